@@ -0,0 +1,122 @@
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include "allocations.hpp"
+
+// The replacements of the global operator new and operator delete that count allocations, built into a program by
+// the DUCKHUNT_TRACK_ALLOCATIONS CMake option. Every form is replaced, so no allocation is made by the standard
+// library's operator new and then freed here, or the other way round.
+
+namespace {
+
+void* allocate(std::size_t size, std::size_t alignment) {
+    threadAllocations.allocations++;
+    threadAllocations.bytes += size;
+    if (size == 0)
+        size = 1;
+    void* memory;
+    if (alignment <= alignof(std::max_align_t))
+        memory = std::malloc(size);
+    else
+        // aligned_alloc wants a size that is a multiple of the alignment
+        memory = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    if (memory != nullptr)
+        liveAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    return memory;
+}
+
+void* allocateOrThrow(std::size_t size, std::size_t alignment) {
+    void* memory = allocate(size, alignment);
+    if (memory == nullptr)
+        throw std::bad_alloc();
+    return memory;
+}
+
+void freeAllocation(void* memory) {
+    if (memory == nullptr)
+        return;
+    liveAllocationCount.fetch_sub(1, std::memory_order_relaxed);
+    std::free(memory);
+}
+
+}
+
+void* operator new(std::size_t size) {
+    return allocateOrThrow(size, alignof(std::max_align_t));
+}
+
+void* operator new[](std::size_t size) {
+    return allocateOrThrow(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return allocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return allocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* memory) noexcept {
+    freeAllocation(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    freeAllocation(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    freeAllocation(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    freeAllocation(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+    freeAllocation(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t) noexcept {
+    freeAllocation(memory);
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept {
+    freeAllocation(memory);
+}
+
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept {
+    freeAllocation(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+    freeAllocation(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {
+    freeAllocation(memory);
+}
+
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept {
+    freeAllocation(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept {
+    freeAllocation(memory);
+}
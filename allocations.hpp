@@ -0,0 +1,143 @@
+#ifndef DUCKHUNT_ALLOCATIONS_HPP
+#define DUCKHUNT_ALLOCATIONS_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+
+// Heap allocations are counted when built with DUCKHUNT_TRACK_ALLOCATIONS, by replacing the global operator new and
+// operator delete. The replacements are defined in allocations.cpp, which CMake only builds into programs that track
+// allocations. Allocations SDL makes with malloc are not counted.
+
+/// A number of heap allocations and the bytes they asked for.
+struct AllocationCount {
+    uint64_t allocations;
+    uint64_t bytes;
+};
+
+#ifdef DUCKHUNT_TRACK_ALLOCATIONS
+
+const bool allocationTracking = true;
+
+/// The allocations made by each thread so far.
+inline thread_local AllocationCount threadAllocations{};
+
+/// The allocations of every thread that have not been freed, shared as memory may be freed on another thread.
+inline std::atomic<int64_t> liveAllocationCount(0);
+
+/// The allocations made by the calling thread so far.
+inline AllocationCount allocationsSoFar() {
+    return threadAllocations;
+}
+
+/// The number of allocations that have not been freed yet, by any thread.
+inline int64_t liveAllocations() {
+    return liveAllocationCount.load(std::memory_order_relaxed);
+}
+
+#else
+
+const bool allocationTracking = false;
+
+inline AllocationCount allocationsSoFar() {
+    return {0, 0};
+}
+
+inline int64_t liveAllocations() {
+    return 0;
+}
+
+#endif
+
+/// Counts the allocations of each frame on the game's thread, and totals them by the scene on top of the stack.
+/// Frames that neither show nor end a scene are steady frames, which should not allocate at all.
+class AllocationStats {
+public:
+    /// The number of scenes totals are kept for, later scenes are not counted.
+    static constexpr int maxScenes = 16;
+
+private:
+    struct SceneAllocations {
+        const char* scene;
+        uint64_t frames;
+        uint64_t steadyFrames;
+        /// The steady frames that allocated.
+        uint64_t steadyFramesAllocating;
+        AllocationCount total;
+        AllocationCount steady;
+    };
+
+    std::array<SceneAllocations, maxScenes> scenes{};
+    int sceneCount = 0;
+    AllocationCount frameStart{};
+    AllocationCount last{};
+
+public:
+    void beginFrame() {
+        frameStart = allocationsSoFar();
+    }
+
+    /// Ends the frame and adds its allocations to the totals of its scene.
+    /// \param scene The name of the scene on top of the stack when the frame started.
+    /// \param steady Whether the frame neither showed nor ended a scene.
+    void endFrame(const char* scene, bool steady) {
+        AllocationCount now = allocationsSoFar();
+        last = {now.allocations - frameStart.allocations, now.bytes - frameStart.bytes};
+        SceneAllocations* entry = find(scene);
+        if (entry == nullptr)
+            return;
+        entry->frames++;
+        add(&entry->total, last);
+        if (steady) {
+            entry->steadyFrames++;
+            add(&entry->steady, last);
+            if (last.allocations > 0)
+                entry->steadyFramesAllocating++;
+        }
+    }
+
+    /// The allocations of the last frame to end.
+    const AllocationCount &lastFrame() const {
+        return last;
+    }
+
+    /// The number of steady frames of a scene that allocated.
+    uint64_t steadyFramesAllocating(const char* scene) const {
+        for (int i = 0; i < sceneCount; ++i)
+            if (std::strcmp(scenes[i].scene, scene) == 0)
+                return scenes[i].steadyFramesAllocating;
+        return 0;
+    }
+
+    /// Writes a line of totals per scene.
+    void report(std::ostream &os) const {
+        for (int i = 0; i < sceneCount; ++i) {
+            const SceneAllocations &entry = scenes[i];
+            os << "Allocations in " << entry.scene << ": " << entry.total.allocations << " (" << entry.total.bytes
+               << " bytes) over " << entry.frames << " frames, " << entry.steady.allocations << " in "
+               << entry.steadyFramesAllocating << " of " << entry.steadyFrames << " steady frames" << std::endl;
+        }
+    }
+
+private:
+    /// Finds the totals of a scene, adding them if the scene has not been seen.
+    /// \return The scene's totals, or nullptr if there is no room for another scene.
+    SceneAllocations* find(const char* scene) {
+        for (int i = 0; i < sceneCount; ++i)
+            if (std::strcmp(scenes[i].scene, scene) == 0)
+                return &scenes[i];
+        if (sceneCount == maxScenes)
+            return nullptr;
+        scenes[sceneCount] = {scene, 0, 0, 0, {0, 0}, {0, 0}};
+        return &scenes[sceneCount++];
+    }
+
+    static void add(AllocationCount* total, const AllocationCount &count) {
+        total->allocations += count.allocations;
+        total->bytes += count.bytes;
+    }
+};
+
+#endif //DUCKHUNT_ALLOCATIONS_HPP
@@ -0,0 +1,57 @@
+#ifndef DUCKHUNT_ALPHA_MASK_HPP
+#define DUCKHUNT_ALPHA_MASK_HPP
+
+#include <cstdint>
+#include <vector>
+#include "SDL2/SDL.h"
+
+/// One bit per pixel of an image, set where the pixel is opaque enough to be hit by a shot.
+class AlphaMask {
+private:
+    /// The lowest alpha that counts as opaque.
+    static constexpr Uint32 threshold = 128;
+
+    int width = 0;
+    int height = 0;
+    /// The number of words in each row.
+    int stride = 0;
+    std::vector<uint64_t> bits;
+
+public:
+    AlphaMask() = default;
+
+    /// Reads the alpha channel of an image.
+    /// \param surface An image in SDL_PIXELFORMAT_ARGB8888, as loadSurface(const std::string &file, std::ostream &os) makes.
+    explicit AlphaMask(SDL_Surface* surface) {
+        if (surface == nullptr || surface->format->format != SDL_PIXELFORMAT_ARGB8888)
+            return;
+        width = surface->w;
+        height = surface->h;
+        stride = (width + 63) / 64;
+        bits.assign(static_cast<size_t>(stride) * height, 0);
+
+        SDL_LockSurface(surface);
+        for (int y = 0; y < height; ++y) {
+            auto row = reinterpret_cast<const Uint32*>(static_cast<const uint8_t*>(surface->pixels) + y * surface->pitch);
+            for (int x = 0; x < width; ++x)
+                if ((row[x] >> 24) >= threshold)
+                    bits[y * stride + x / 64] |= uint64_t(1) << (x % 64);
+        }
+        SDL_UnlockSurface(surface);
+    }
+
+    /// Whether the mask was made from an image, an empty mask cannot tell which pixels are opaque.
+    bool isEmpty() const {
+        return bits.empty();
+    }
+
+    /// Whether a pixel is opaque.
+    /// \return false for points outside the image.
+    bool test(int x, int y) const {
+        if (x < 0 || y < 0 || x >= width || y >= height)
+            return false;
+        return (bits[y * stride + x / 64] >> (x % 64) & 1) != 0;
+    }
+};
+
+#endif //DUCKHUNT_ALPHA_MASK_HPP
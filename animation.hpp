@@ -1,51 +1,101 @@
 #ifndef DUCKHUNT_ANIMATION_HPP
 #define DUCKHUNT_ANIMATION_HPP
 
-#include <algorithm>
-#include <vector>
+#include <array>
+#include <cstdint>
+#include <type_traits>
 #include "SDL2/SDL.h"
-#include "timer.hpp"
 #include "textures.hpp"
 
-class Animation {
-private:
-    long currentFrame;
-    Timer timer;
-    std::vector<SDL_Rect> frames;
-public:
-    SDL_Texture* texture;
-public:
-    Animation(SDL_Texture* texture, size_t numberOfFrames, int framesPerSecond = 1) : timer(1000.0 / framesPerSecond) {
-        this->texture = texture;
-        frames = spriteStripRects(texture, numberOfFrames);
-        currentFrame = 0;
-    }
+/// The animations that are played in a loop, indexes into animationClips.
+enum ClipId : uint8_t {
+    CLIP_DOG_FAILURE,
+    CLIP_DUCK_BLUE_DEAD,
+    CLIP_DUCK_BLUE_FALLING,
+    CLIP_DUCK_BLUE_DIAGONAL,
+    CLIP_DUCK_BLUE_HORIZONTAL,
+    CLIP_DUCK_BLUE_VERTICAL,
+    CLIP_DUCK_BROWN_DEAD,
+    CLIP_DUCK_BROWN_FALLING,
+    CLIP_DUCK_BROWN_DIAGONAL,
+    CLIP_DUCK_BROWN_HORIZONTAL,
+    CLIP_DUCK_BROWN_VERTICAL,
+    CLIP_DUCK_RED_DEAD,
+    CLIP_DUCK_RED_FALLING,
+    CLIP_DUCK_RED_DIAGONAL,
+    CLIP_DUCK_RED_HORIZONTAL,
+    CLIP_DUCK_RED_VERTICAL,
+    CLIP_COUNT
+};
 
-    /// Advances the animation and returns the current frame.
-    /// \param deltaTime the time since the last frame.
-    /// \return the rect for the current frame.
-    const SDL_Rect* advance(double deltaTime) {
-        if (timer.tick(deltaTime))
-            currentFrame = ++currentFrame % frames.size();
-        return frame();
-    }
+/// An animation strip, shared by everything that plays it.
+struct AnimationClip {
+    TextureRegion Textures::* region;
+    int frames;
+};
 
-    void reset(int framesPerSecond) {
-        timer.reset(1000.0 / framesPerSecond);
-        currentFrame = 0;
+const std::array<AnimationClip, CLIP_COUNT> animationClips = {{
+    {&Textures::dog_failure, 2},
+    {&Textures::duck_blue_dead, 1},
+    {&Textures::duck_blue_falling, 4},
+    {&Textures::duck_blue_diagonal, 3},
+    {&Textures::duck_blue_horizontal, 3},
+    {&Textures::duck_blue_vertical, 3},
+    {&Textures::duck_brown_dead, 1},
+    {&Textures::duck_brown_falling, 4},
+    {&Textures::duck_brown_diagonal, 3},
+    {&Textures::duck_brown_horizontal, 3},
+    {&Textures::duck_brown_vertical, 3},
+    {&Textures::duck_red_dead, 1},
+    {&Textures::duck_red_falling, 4},
+    {&Textures::duck_red_diagonal, 3},
+    {&Textures::duck_red_horizontal, 3},
+    {&Textures::duck_red_vertical, 3}
+}};
+
+/// The strip of a clip in a texture set.
+inline SpriteStrip clipStrip(const Textures* textures, ClipId clip) {
+    return {&(textures->*animationClips[clip].region), animationClips[clip].frames};
+}
+
+/// How far something is through an AnimationClip. The clip's strip is looked up when drawing, so a playhead is a
+/// few bytes that can be copied without allocating, and it follows the textures when the texture set changes.
+struct Playhead {
+    ClipId clip;
+    uint8_t frame;
+    /// The time the current frame has been shown for in ms.
+    float elapsed;
+
+    /// Starts playing a clip from its first frame, unless it is already playing.
+    void play(ClipId clip) {
+        if (this->clip == clip)
+            return;
+        this->clip = clip;
+        frame = 0;
+        elapsed = 0.0f;
     }
 
-    const SDL_Rect* frame() {
-        return &frames[currentFrame];
+    /// Moves through the clip, looping back to its first frame after the last.
+    /// \param deltaTime The time since the last frame in ms.
+    /// \param frameLength How long each frame is shown for in ms.
+    void advance(double deltaTime, double frameLength) {
+        elapsed += static_cast<float>(deltaTime);
+        if (elapsed > frameLength) {
+            elapsed = 0.0f;
+            frame = static_cast<uint8_t>((frame + 1) % animationClips[clip].frames);
+        }
     }
 
-    int frameWidth() {
-        return frames.at(0).w;
+    SDL_Texture* texture(const Textures* textures) const {
+        return clipStrip(textures, clip).texture();
     }
 
-    int frameHeight() {
-        return frames.at(0).h;
+    /// The rect of the current frame, in atlas coordinates.
+    SDL_Rect rect(const Textures* textures) const {
+        return clipStrip(textures, clip).frame(frame);
     }
 };
 
+static_assert(std::is_trivially_copyable<Playhead>::value, "Playhead must stay trivially copyable");
+
 #endif //DUCKHUNT_ANIMATION_HPP
@@ -0,0 +1,142 @@
+#ifndef DUCKHUNT_ATLAS_HPP
+#define DUCKHUNT_ATLAS_HPP
+
+#include <vector>
+#include <algorithm>
+#include "SDL2/SDL.h"
+#include "errors.hpp"
+#include "texture_count.hpp"
+
+/// A rectangular region of a texture, usually a sprite on a texture atlas page.
+struct TextureRegion {
+    SDL_Texture* texture;
+    SDL_Rect rect;
+    /// The index of the mask of the region's image in Textures::masks, or -1 if it has none.
+    int mask = -1;
+};
+
+/// Packs many small surfaces onto a few large atlas pages, so that drawing them does not switch textures.
+class AtlasBuilder {
+private:
+    struct Entry {
+        SDL_Surface* surface;
+        TextureRegion* region;
+        int page;
+    };
+
+    /// Empty pixels left between sprites, so that scaled sprites do not bleed into their neighbours.
+    const int padding = 1;
+    int pageWidth;
+    int pageHeight;
+    std::vector<Entry> entries;
+
+public:
+    /// Creates an atlas builder.
+    /// \param renderer The renderer the atlas pages will be created on, used to query the largest texture size.
+    /// \param maxPageSize The largest width and height of an atlas page.
+    explicit AtlasBuilder(SDL_Renderer* renderer, int maxPageSize = 2048) {
+        pageWidth = maxPageSize;
+        pageHeight = maxPageSize;
+        SDL_RendererInfo info;
+        if (renderer != nullptr && SDL_GetRendererInfo(renderer, &info) == 0) {
+            if (info.max_texture_width > 0)
+                pageWidth = std::min(pageWidth, info.max_texture_width);
+            if (info.max_texture_height > 0)
+                pageHeight = std::min(pageHeight, info.max_texture_height);
+        }
+    }
+
+    /// Queues a surface to be packed. The region is filled in by ::build(SDL_Renderer* renderer).
+    /// \param surface The surface to pack, this is not freed by the builder.
+    /// \param region The region to write the surface's location on the atlas to.
+    void add(SDL_Surface* surface, TextureRegion* region) {
+        *region = {nullptr, {0, 0, 0, 0}};
+        if (surface != nullptr)
+            entries.push_back({surface, region, -1});
+    }
+
+    /// Packs all queued surfaces and uploads the atlas pages.
+    /// \param renderer The renderer to create the pages on, or nullptr to only pack the regions.
+    /// \return The atlas pages, which the caller owns.
+    std::vector<SDL_Texture*> build(SDL_Renderer* renderer) {
+        std::vector<SDL_Rect> pageSizes = pack();
+
+        std::vector<SDL_Texture*> pages;
+        if (renderer == nullptr) {
+            entries.clear();
+            return pages;
+        }
+        for (int page = 0; page < pageSizes.size(); ++page) {
+            SDL_Surface* pageSurface = SDL_CreateRGBSurfaceWithFormat(0, pageSizes[page].w, pageSizes[page].h, 32, SDL_PIXELFORMAT_ARGB8888);
+            if (pageSurface == nullptr) {
+                logSDLError(std::cout, "CreateRGBSurfaceWithFormat");
+                continue;
+            }
+            for (auto &entry : entries) {
+                if (entry.page != page)
+                    continue;
+                SDL_Rect dst = entry.region->rect;
+                SDL_SetSurfaceBlendMode(entry.surface, SDL_BLENDMODE_NONE);
+                SDL_BlitSurface(entry.surface, nullptr, pageSurface, &dst);
+            }
+
+            SDL_Texture* texture = createTextureFromSurface(renderer, pageSurface);
+            SDL_FreeSurface(pageSurface);
+            if (texture == nullptr) {
+                logSDLError(std::cout, "CreateTextureFromSurface");
+                continue;
+            }
+            SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+            pages.push_back(texture);
+            for (auto &entry : entries)
+                if (entry.page == page)
+                    entry.region->texture = texture;
+        }
+        entries.clear();
+        return pages;
+    }
+
+private:
+    /// Shelf packs the entries, tallest first, assigning each a page and a rect on that page.
+    /// \return The used size of each page.
+    std::vector<SDL_Rect> pack() {
+        std::vector<Entry*> order;
+        order.reserve(entries.size());
+        for (auto &entry : entries)
+            order.push_back(&entry);
+        std::stable_sort(order.begin(), order.end(), [](const Entry* a, const Entry* b) {
+            return a->surface->h > b->surface->h;
+        });
+
+        std::vector<SDL_Rect> pageSizes;
+        int shelfX = 0, shelfY = 0, shelfHeight = 0;
+        for (Entry* entry : order) {
+            int w = entry->surface->w;
+            int h = entry->surface->h;
+
+            // Start a new shelf, or a new page, when this sprite does not fit
+            if (!pageSizes.empty() && shelfX + w > pageWidth) {
+                shelfX = 0;
+                shelfY += shelfHeight + padding;
+                shelfHeight = 0;
+            }
+            if (pageSizes.empty() || shelfY + h > pageHeight) {
+                pageSizes.push_back({0, 0, 0, 0});
+                shelfX = 0;
+                shelfY = 0;
+                shelfHeight = 0;
+            }
+
+            SDL_Rect &pageSize = pageSizes.back();
+            entry->page = static_cast<int>(pageSizes.size()) - 1;
+            entry->region->rect = {shelfX, shelfY, w, h};
+            pageSize.w = std::max(pageSize.w, shelfX + w);
+            pageSize.h = std::max(pageSize.h, shelfY + h);
+            shelfX += w + padding;
+            shelfHeight = std::max(shelfHeight, h);
+        }
+        return pageSizes;
+    }
+};
+
+#endif //DUCKHUNT_ATLAS_HPP
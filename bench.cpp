@@ -0,0 +1,229 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include "cleanup.hpp"
+#include "level.hpp"
+#include "config.hpp"
+#include "session.hpp"
+
+// Microbenchmarks of the game's hot paths. Each benchmark is run for a number of samples of a fixed number of
+// iterations, and the results are written as JSON, e.g.
+//   duckhunt_bench --out bench.json --filter Duck --samples 20
+
+const int WORLD_WIDTH = 256 * 3;
+const int WORLD_HEIGHT = 224 * 3;
+const std::string BENCH_CONFIG_PATH = "./bench_config.cfg";
+const size_t SWARM_SIZE = 10000;
+
+/// A benchmark: a setup run before every sample, untimed, and the code being timed.
+struct Benchmark {
+    std::string name;
+    int iterations;
+    std::function<void()> setup;
+    std::function<void()> run;
+};
+
+/// The time per iteration of each sample of a benchmark.
+struct BenchmarkResult {
+    std::string name;
+    int iterations;
+    std::vector<double> nsPerIteration;
+};
+
+/// Exposes the protected parts of a Level that the benchmarks reset between samples.
+class BenchLevel : public Level {
+public:
+    BenchLevel(Session *session, Drawer *drawer, Player_Stats *player_stats, Textures *textures)
+        : Level(session, drawer, player_stats, textures) {}
+
+    void reset() {
+        ducks.clear();
+        ducks.reserve(1024);
+        player_stats->duck_next = 0;
+        player_stats->ducks_current = 0;
+    }
+
+    /// Moves the ducks a step and shoots at a point, as a frame with a shot does.
+    Duck* moveAndShoot(int worldX, int worldY) {
+        int landedX;
+        DuckColours landedColour;
+        stepFlight(1000.0 / 120.0, &landedX, &landedColour);
+        return duckAt(worldX, worldY);
+    }
+};
+
+BenchmarkResult runBenchmark(const Benchmark &benchmark, int samples) {
+    using clock = std::chrono::steady_clock;
+    BenchmarkResult result{benchmark.name, benchmark.iterations, {}};
+
+    // Warm up caches and the branch predictor with one untimed sample
+    benchmark.setup();
+    for (int i = 0; i < benchmark.iterations; ++i)
+        benchmark.run();
+
+    for (int sample = 0; sample < samples; ++sample) {
+        benchmark.setup();
+        auto start = clock::now();
+        for (int i = 0; i < benchmark.iterations; ++i)
+            benchmark.run();
+        auto end = clock::now();
+        double ns = std::chrono::duration<double, std::nano>(end - start).count();
+        result.nsPerIteration.push_back(ns / benchmark.iterations);
+    }
+    return result;
+}
+
+void writeResults(std::ostream &os, const std::vector<BenchmarkResult> &results) {
+    using boost::property_tree::ptree;
+    using boost::property_tree::json_parser::write_json;
+    ptree pt;
+    ptree benchmarks;
+    for (auto result : results) {
+        std::sort(result.nsPerIteration.begin(), result.nsPerIteration.end());
+        double sum = 0.0;
+        for (double ns : result.nsPerIteration)
+            sum += ns;
+
+        ptree benchmark;
+        benchmark.put("name", result.name);
+        benchmark.put("iterations", result.iterations);
+        benchmark.put("samples", result.nsPerIteration.size());
+        benchmark.put("min_ns", result.nsPerIteration.front());
+        benchmark.put("median_ns", result.nsPerIteration[result.nsPerIteration.size() / 2]);
+        benchmark.put("mean_ns", sum / result.nsPerIteration.size());
+        benchmark.put("max_ns", result.nsPerIteration.back());
+        benchmarks.push_back(std::make_pair("", benchmark));
+    }
+    pt.add_child("benchmarks", benchmarks);
+    write_json(os, pt);
+}
+
+int main(int argc, char* argv []) {
+    std::string outPath;
+    std::string filter;
+    int samples = 10;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--out" && i + 1 < argc)
+            outPath = argv[++i];
+        else if (arg == "--filter" && i + 1 < argc)
+            filter = argv[++i];
+        else if (arg == "--samples" && i + 1 < argc)
+            samples = std::max(1, std::atoi(argv[++i]));
+        else {
+            std::cout << "Usage: " << argv[0] << " [--out FILE] [--filter NAME] [--samples N]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (SDL_Init(SDL_INIT_TIMER) != 0) {
+        logSDLError(std::cout, "SDL_Init");
+        return 1;
+    }
+
+    // Draw to a surface with the software renderer, so no window or GPU is needed
+    SDL_Surface* target = SDL_CreateRGBSurfaceWithFormat(0, WORLD_WIDTH, WORLD_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+    SDL_Renderer* renderer = target != nullptr ? SDL_CreateSoftwareRenderer(target) : nullptr;
+    if (renderer == nullptr) {
+        logSDLError(std::cout, "CreateSoftwareRenderer");
+        SDL_FreeSurface(target);
+        SDL_Quit();
+        return 1;
+    }
+
+    Textures textures = loadTexturesRemake(renderer);
+    if (!validateTextures(&textures)) {
+        cleanup(&textures, renderer, nullptr);
+        SDL_FreeSurface(target);
+        return 1;
+    }
+
+    Session session;
+    session.random.seed(1);
+    Drawer drawer(textures.background, renderer, WORLD_WIDTH, WORLD_HEIGHT);
+    Player_Stats stats = Level::singleDuckGame();
+    DuckHatchery hatchery(&textures, &drawer, &session.random);
+    BenchLevel level(&session, &drawer, &stats, &textures);
+    Player_Stats endlessStats = Level::endlessGame(0);
+    Level::setEndlessDucks(&endlessStats, 10);
+    BenchLevel endlessLevel(&session, &drawer, &endlessStats, &textures);
+    Duck duck = hatchery.newDuck(BLUE, 1000, 1, 0);
+    DuckSwarm swarm(&textures, &drawer, &session.random);
+    swarm.spawn(SWARM_SIZE);
+    int score = 0;
+
+    Config config{};
+    config.highScore = 123456;
+    config.useRemakeTextures = true;
+    config.nativeResolution = false;
+    config.integerScaling = false;
+    config.save(BENCH_CONFIG_PATH);
+
+    std::vector<Benchmark> benchmarks = {
+        {"Duck::update", 100000,
+            [&]() { duck = hatchery.newDuck(BLUE, 1000, 1, 0); },
+            [&]() { duck.storePosition(); duck.update(1000.0 / 120.0); }},
+        {"DuckSwarm::update 10000 ducks", 1000,
+            []() {},
+            [&]() { swarm.update(1000.0 / 120.0); }},
+        // Shots are timed with the move before them, as the ducks move every frame
+        {"DuckSwarm::update then hitTest 10000 ducks", 1000,
+            []() {},
+            [&]() { swarm.update(1000.0 / 120.0); swarm.hitTest(200, 80); }},
+        {"Level::duckAt after moving 512 ducks", 10000,
+            []() {},
+            [&]() { endlessLevel.moveAndShoot(200, 80); }},
+        {"DuckHatchery::newDuck", 10000,
+            []() {},
+            [&]() { duck = hatchery.newDuck(RED, 1500, 1, 0); }},
+        {"spriteStripRects", 100000,
+            []() {},
+            [&]() { spriteStripRects(textures.dog_sniffing, 7); }},
+        {"Drawer::renderUI cached", 1000,
+            [&]() { drawer.clear(); },
+            [&]() { drawer.renderUI(1000.0 / 60.0, &textures, &stats); }},
+        {"Drawer::renderUI changed", 1000,
+            [&]() { drawer.clear(); },
+            [&]() { stats.score = score++ % 1000000; drawer.renderUI(1000.0 / 60.0, &textures, &stats); }},
+        {"Drawer::renderCharacter", 10000,
+            [&]() { drawer.clear(); },
+            [&]() { drawer.renderCharacter(textures.font_white, '7', 100, 100); }},
+        {"Level::spawnDuck", 1000,
+            [&]() { level.reset(); },
+            [&]() { level.spawnDuck(); }},
+        {"Config::load", 100,
+            []() {},
+            [&]() { config.load(BENCH_CONFIG_PATH); }},
+    };
+
+    std::vector<BenchmarkResult> results;
+    for (auto &benchmark : benchmarks) {
+        if (!filter.empty() && benchmark.name.find(filter) == std::string::npos)
+            continue;
+        std::cerr << "Running " << benchmark.name << std::endl;
+        results.push_back(runBenchmark(benchmark, samples));
+    }
+    drawer.clear();
+
+    if (outPath.empty())
+        writeResults(std::cout, results);
+    else {
+        std::ofstream out(outPath, std::ios::trunc);
+        writeResults(out, results);
+    }
+
+    std::remove(BENCH_CONFIG_PATH.c_str());
+    cleanup_textures(&textures);
+    SDL_DestroyRenderer(renderer);
+    SDL_FreeSurface(target);
+    IMG_Quit();
+    SDL_Quit();
+    return 0;
+}
@@ -3,13 +3,19 @@
 
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
+#include "trace.hpp"
 
 struct Config
 {
     int highScore;
     bool useRemakeTextures;
+    /// Draw the game at its own resolution and scale it up to the window once per frame.
+    bool nativeResolution;
+    /// Only scale the native resolution up by whole numbers.
+    bool integerScaling;
 
     void load(const std::string &filename) {
+        TRACE_ZONE("Config::load");
         try {
             using boost::property_tree::ptree;
             using boost::property_tree::json_parser::read_json;
@@ -19,20 +25,27 @@ struct Config
 
             highScore = pt.get("highScore", 0);
             useRemakeTextures = pt.get("useRemakeTextures", true);
+            nativeResolution = pt.get("nativeResolution", false);
+            integerScaling = pt.get("integerScaling", false);
         }
         catch (const boost::property_tree::json_parser_error& e1) {
             highScore = 0;
             useRemakeTextures = true;
+            nativeResolution = false;
+            integerScaling = false;
         }
     }
 
     void save(const std::string &filename) {
+        TRACE_ZONE("Config::save");
         using boost::property_tree::ptree;
         using boost::property_tree::json_parser::write_json;
         ptree pt;
 
         pt.put("highScore", highScore);
         pt.put("useRemakeTextures", useRemakeTextures);
+        pt.put("nativeResolution", nativeResolution);
+        pt.put("integerScaling", integerScaling);
 
         // Write the property tree to the XML file.
         write_json(filename, pt);
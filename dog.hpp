@@ -1,6 +1,7 @@
 #ifndef DUCKHUNT_DOG_HPP
 #define DUCKHUNT_DOG_HPP
 
+#include <array>
 #include <SDL2/SDL.h>
 #include "drawing.hpp"
 #include "duck.hpp"
@@ -8,23 +9,19 @@
 
 class DogSniffing {
 private:
-    SDL_Texture* tex_sniffing;
-    std::vector<SDL_Rect> frames;
+    SpriteStrip frames;
     int currentFrame;
     double frameTime;
     double frameLength;
-    std::vector<int> sniffingAnimation = {0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 0, 4, 4, 0, 0, 4, 4, 0, 0, 4, 4, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 0, 4, 4, 0, 0, 4, 4, 0, 0, 4, 4, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 0, 4, 4, 0, 0, 4, 4, 0, 0, 4, 4, 5, 5, 5};
-    std::vector<int> sniffingMovement  = {2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    static constexpr std::array<int, 87> sniffingAnimation = {0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 0, 4, 4, 0, 0, 4, 4, 0, 0, 4, 4, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 0, 4, 4, 0, 0, 4, 4, 0, 0, 4, 4, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 0, 4, 4, 0, 0, 4, 4, 0, 0, 4, 4, 5, 5, 5};
+    static constexpr std::array<int, 87> sniffingMovement  = {2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
 public:
     int x;
     int y;
 
 public:
-    DogSniffing(SDL_Texture* tex_sniffing, int framesPerSecond) {
-        this->tex_sniffing = tex_sniffing;
-
-        // Get rect of each frame
-        frames = spriteStripRects(tex_sniffing, 6);
+    DogSniffing(const TextureRegion &tex_sniffing, int framesPerSecond) {
+        frames = {&tex_sniffing, 6};
 
         x = 88;
         y = 145;
@@ -41,8 +38,10 @@ public:
             if (currentFrame < sniffingAnimation.size())
                 x += sniffingMovement[currentFrame];
         }
-        if (currentFrame < sniffingAnimation.size())
-            drawer->renderTexture(tex_sniffing, x, y, &frames[sniffingAnimation[currentFrame]]);
+        if (currentFrame < sniffingAnimation.size()) {
+            SDL_Rect frame = frames.frame(sniffingAnimation[currentFrame]);
+            drawer->renderTexture(frames.texture(), x, y, &frame);
+        }
         else
             return true;
         return false;
@@ -51,8 +50,7 @@ public:
 
 class DogJumping {
 private:
-    SDL_Texture* tex_jumping;
-    SDL_Rect frames[2];
+    SpriteStrip frames;
     int currentFrame;
     double frameTime;
     double frameLength;
@@ -61,19 +59,8 @@ public:
     int y;
 
 public:
-    DogJumping(SDL_Texture* tex_sniffing, int framesPerSecond) {
-        this->tex_jumping = tex_sniffing;
-
-        // Get rect of each frame
-        int w, h;
-        SDL_QueryTexture(tex_sniffing, nullptr, nullptr, &w, &h);
-        w /= 2;
-        for (int i = 0; i < 2; ++i) {
-            frames[i].x = w * i;
-            frames[i].y = 0;
-            frames[i].w = w;
-            frames[i].h = h;
-        }
+    DogJumping(const TextureRegion &tex_sniffing, int framesPerSecond) {
+        frames = {&tex_sniffing, 2};
 
         currentFrame = 1;
         frameTime = 0.0;
@@ -92,7 +79,8 @@ public:
             else
                 return true;
         }
-        drawer->renderTexture(tex_jumping, x, y, &frames[0]);
+        SDL_Rect frame = frames.frame(0);
+        drawer->renderTexture(frames.texture(), x, y, &frame);
         return false;
     }
 
@@ -108,7 +96,8 @@ public:
             else
                 return true;
         }
-        drawer->renderTexture(tex_jumping, x, y, &frames[1]);
+        SDL_Rect frame = frames.frame(1);
+        drawer->renderTexture(frames.texture(), x, y, &frame);
         return false;
     }
 };
@@ -122,30 +111,29 @@ private:
     int x;
     double y;
     double speed;
-    SDL_Texture* texture;
-    SDL_Rect frame;
+    SpriteStrip frames;
+    int frame;
     DogSuccessState state;
     Timer timer = Timer(0);
     int yTopLimit;
     int yBottomLimit;
 
 public:
-    DogSuccess(int x, int yBottom, int yTop, SDL_Texture* texture_success, DuckColours colour, double speed) : DogSuccess(x, yBottom, yTop, texture_success, speed) {
-        auto frames = spriteStripRects(texture_success, 12);
+    DogSuccess(int x, int yBottom, int yTop, const TextureRegion &texture_success, DuckColours colour, double speed) : DogSuccess(x, yBottom, yTop, texture_success, speed) {
         switch (colour) {
             case BLUE:
-                frame = frames[1];
+                frame = 1;
                 break;
             case RED:
-                frame = frames[2];
+                frame = 2;
                 break;
             default:
-                frame = frames[0];
+                frame = 0;
                 break;
         }
     }
 
-    DogSuccess(int x, int yBottom, int yTop, SDL_Texture* texture_success, DuckColours colour1, DuckColours colour2, double speed) : DogSuccess(x, yBottom, yTop, texture_success, speed) {
+    DogSuccess(int x, int yBottom, int yTop, const TextureRegion &texture_success, DuckColours colour1, DuckColours colour2, double speed) : DogSuccess(x, yBottom, yTop, texture_success, speed) {
         int index;
         switch (colour1) {
             case BLUE:
@@ -169,7 +157,7 @@ public:
                 index += 0;
                 break;
         }
-        frame = spriteStripRects(texture_success, 12)[index];
+        frame = index;
     }
 
     ///
@@ -182,7 +170,8 @@ public:
         else if (state == DOWN)
             y += speed * deltaTime;
 
-        drawer->renderTexture(texture, x, static_cast<int>(y), &frame);
+        SDL_Rect rect = frames.frame(frame);
+        drawer->renderTexture(frames.texture(), x, static_cast<int>(y), &rect);
 
         if (state == UP && y < yTopLimit) {
             state = STOPPED;
@@ -196,12 +185,13 @@ public:
     }
 
 private:
-    DogSuccess(int x, int yBottom, int yTop, SDL_Texture* texture_success, double speed) {
+    DogSuccess(int x, int yBottom, int yTop, const TextureRegion &texture_success, double speed) {
         this->x = x;
         y = yBottom;
         yBottomLimit = yBottom;
         yTopLimit = yTop;
-        texture = texture_success;
+        frames = {&texture_success, 12};
+        frame = 0;
         this->speed = speed;
         state = UP;
     }
@@ -214,13 +204,17 @@ private:
     double speed;
     DogSuccessState state;
     Timer timer = Timer(0);
-    Animation animation;
+    const Textures* textures;
+    Playhead playhead;
+    double frameLength;
     int yTopLimit;
     int yBottomLimit;
 
 public:
-    DogFailure(int x, int yBottom, int yTop, SDL_Texture* texture_failure, double speed, int framePerSecond)
-        : animation(texture_failure, 2, framePerSecond) {
+    DogFailure(int x, int yBottom, int yTop, const Textures* textures, double speed, int framePerSecond) {
+        this->textures = textures;
+        playhead = {CLIP_DOG_FAILURE, 0, 0.0f};
+        frameLength = 1000.0 / framePerSecond;
         this->x = x;
         y = yBottom;
         yBottomLimit = yBottom;
@@ -239,7 +233,9 @@ public:
         else if (state == DOWN)
             y += speed * deltaTime;
 
-        drawer->renderTexture(animation.texture, x, static_cast<int>(y), animation.advance(deltaTime));
+        playhead.advance(deltaTime, frameLength);
+        SDL_Rect frame = playhead.rect(textures);
+        drawer->renderTexture(playhead.texture(textures), x, static_cast<int>(y), &frame);
 
         if (state == UP && y < yTopLimit) {
             state = STOPPED;
@@ -260,12 +256,16 @@ private:
     double speed;
     DogSuccessState state;
     Timer timer = Timer(0);
-    Animation animation;
+    const Textures* textures;
+    Playhead playhead;
+    double frameLength;
     int yTopLimit;
 
 public:
-    DogGameOver(int x, int yBottom, int yTop, SDL_Texture* texture_failure, double speed, int framePerSecond)
-        : animation(texture_failure, 2, framePerSecond) {
+    DogGameOver(int x, int yBottom, int yTop, const Textures* textures, double speed, int framePerSecond) {
+        this->textures = textures;
+        playhead = {CLIP_DOG_FAILURE, 0, 0.0f};
+        frameLength = 1000.0 / framePerSecond;
         this->x = x;
         y = yBottom;
         yTopLimit = yTop;
@@ -279,7 +279,9 @@ public:
         else if (state == DOWN)
             y += speed * deltaTime;
 
-        drawer->renderTexture(animation.texture, x, static_cast<int>(y), animation.advance(deltaTime));
+        playhead.advance(deltaTime, frameLength);
+        SDL_Rect frame = playhead.rect(textures);
+        drawer->renderTexture(playhead.texture(textures), x, static_cast<int>(y), &frame);
 
         if (state == UP && y < yTopLimit) {
             state = STOPPED;
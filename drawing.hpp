@@ -2,16 +2,73 @@
 #define DUCKHUNT_DRAWING_HPP
 
 #include <algorithm>
+#include <array>
+#include <cmath>
 #include "errors.hpp"
 #include "player_stats.hpp"
 #include "timer.hpp"
+#include "textures.hpp"
+#include "sprite_batch.hpp"
+#include "frame_timer.hpp"
+#include "texture_count.hpp"
 #include "SDL2/SDL.h"
 
+/// Everything the HUD is drawn from, used to tell when the cached HUD is out of date.
+struct HUDState {
+    const Textures* textures;
+    int shots_left;
+    std::array<bool, 10> ducks_hit;
+    /// Bit i is set when duck i is on screen.
+    unsigned int ducks_current;
+    int ducks_needed;
+    int round;
+    int score;
+    /// Only the ducks on screen flicker, so the flicker is only part of the state while ::ducks_current is not 0.
+    bool isFlickering;
+
+    bool operator==(const HUDState &other) const {
+        return textures == other.textures && shots_left == other.shots_left && ducks_hit == other.ducks_hit &&
+               ducks_current == other.ducks_current && ducks_needed == other.ducks_needed &&
+               round == other.round && score == other.score &&
+               (ducks_current == 0 || isFlickering == other.isFlickering);
+    }
+};
+
 class Drawer {
 private:
+    /// Where textures are drawn to: a sprite queue and the transform from world to canvas pixels.
+    struct Canvas {
+        SpriteBatch* batch;
+        float scale;
+        int x_offset;
+        int y_offset;
+    };
+
+    /// The part of the world the HUD covers.
+    const SDL_Rect hudBounds = {104, 188, 224, 40};
+
     SDL_Renderer *renderer;
+    SpriteBatch batch;
+    Canvas canvas;
     bool isFlickering = false;
     Timer flickerTimer = Timer(500);
+    NumberLabel roundLabel = NumberLabel(1);
+    NumberLabel scoreLabel = NumberLabel(6);
+
+    // The HUD is drawn at world resolution onto its own texture, and only redrawn when it changes.
+    SpriteBatch hudBatch;
+    SDL_Texture* hudTexture = nullptr;
+    bool hudSupported = true;
+    bool hudValid = false;
+    HUDState hudState{};
+    // In native resolution mode the world is drawn 1:1 onto this texture, which is then scaled up to the window.
+    SDL_Texture* nativeTarget = nullptr;
+    /// Where the native texture is drawn on the window.
+    SDL_Rect nativeDestination{};
+    // Drawn on top of everything at window resolution when set.
+    FrameTimeOverlay frameTimeOverlay;
+    const FrameTimer* frameTimes = nullptr;
+    const BitmapFont* frameTimesFont = nullptr;
 public:
     /// The factor to scale textures by to match the window.
     float scale;
@@ -23,37 +80,105 @@ public:
 public:
     /// Creates aspect ratio invariant drawing functions.
     /// \param background The background image.
-    /// \param ren The renderer we want to draw to.
+    /// \param ren The renderer we want to draw to, or nullptr to draw nothing, e.g. when running headless.
     /// \param window_width The width of the window.
     /// \param window_height The height of the window.
-    Drawer(SDL_Texture *background, SDL_Renderer *ren, const int window_width, const int window_height) {
+    /// \param nativeResolution true to draw the world at its own resolution and scale it up once when presenting.
+    /// \param integerScaling true to only scale the native resolution by whole numbers, letterboxing the rest.
+    Drawer(const TextureRegion &background, SDL_Renderer *ren, const int window_width, const int window_height,
+           bool nativeResolution = false, bool integerScaling = false) {
         this->renderer = ren;
         this->window_width = window_width;
 
-        int w, h;
-        SDL_QueryTexture(background, nullptr, nullptr, &w, &h);
+        int w = background.rect.w;
+        int h = background.rect.h;
         this->scale = static_cast<float>(window_height) / static_cast<float>(h);
         w = static_cast<int>(w * scale);
         this->x_offset = static_cast<int>((static_cast<float>(window_width) - static_cast<float>(w)) / 2.0f);
+        canvas = {&batch, scale, x_offset, 0};
+
+        if (renderer == nullptr)
+            hudSupported = false;
+        else if (nativeResolution)
+            createNativeTarget(h, window_height, integerScaling);
+    }
+
+    Drawer(const Drawer&) = delete;
+    Drawer& operator=(const Drawer&) = delete;
+
+    ~Drawer() {
+        destroyTexture(hudTexture);
+        destroyTexture(nativeTarget);
     }
 
     SDL_Renderer* getRenderer() {
         return renderer;
     }
 
-    void renderCharacter(SDL_Texture* numbers_texture, char character, int x, int y) {
-        // Get width and height of each character
-        int w, h;
-        SDL_QueryTexture(numbers_texture, nullptr, nullptr, &w, &h);
-        w /= 10;
+    /// Starts a new frame, discarding anything queued but not presented.
+    void clear() {
+        batch.clear();
+        batch.layer = LAYER_BACKGROUND;
+        if (renderer == nullptr)
+            return;
+        if (nativeTarget != nullptr)
+            SDL_SetRenderTarget(renderer, nativeTarget);
+        SDL_RenderClear(renderer);
+    }
+
+    /// Sets the layer subsequent textures are drawn on.
+    void setLayer(DrawLayer layer) {
+        batch.layer = layer;
+    }
+
+    /// Draws everything queued this frame and shows it on screen.
+    void present() {
+        if (renderer == nullptr)
+            return;
+        batch.flush(renderer);
+        if (nativeTarget != nullptr) {
+            SDL_SetRenderTarget(renderer, nullptr);
+            SDL_RenderClear(renderer);
+            SDL_RenderCopy(renderer, nativeTarget, nullptr, &nativeDestination);
+        }
+        if (frameTimes != nullptr && frameTimesFont != nullptr)
+            frameTimeOverlay.render(renderer, *frameTimes, *frameTimesFont);
+        SDL_RenderPresent(renderer);
+    }
 
-        std::string numbers = "0123456789";
-        std::size_t pos = numbers.find(character);
-        if (pos == std::string::npos)
-            pos = 0;
+    /// Sets the frame times drawn over the next presented frames.
+    /// \param timer The frame times to show, or nullptr to hide the overlay.
+    /// \param font The font to draw the times in.
+    void showFrameTimes(const FrameTimer* timer, const BitmapFont* font) {
+        frameTimes = timer;
+        frameTimesFont = font;
+    }
+
+    /// The left edge of the world that can be seen in the window.
+    double worldLeft() {
+        return -x_offset / scale;
+    }
+
+    /// The right edge of the world that can be seen in the window.
+    double worldRight() {
+        return window_width / scale + worldLeft();
+    }
 
-        SDL_Rect clip = {.x = static_cast<int>(pos * w), .y = 0, .w = w, .h = h};
-        renderTexture(numbers_texture, x, y, &clip);
+    /// Draws a single character of a bitmap font.
+    void renderCharacter(const BitmapFont &font, char character, int x, int y) {
+        renderTexture(font.texture, x, y, font.glyph(character));
+    }
+
+    /// Draws a number, left aligned.
+    /// \param label The laid out number.
+    /// \param x The x coordinate of the first character.
+    /// \param y The y coordinate to draw to.
+    void renderNumber(const NumberLabel &label, int x, int y) {
+        const BitmapFont* font = label.getFont();
+        if (font == nullptr)
+            return;
+        for (int i = 0; i < label.size(); ++i)
+            renderTexture(font->texture, x + i * font->advance, y, label.glyph(i));
     }
 
     /// Draw an SDL_Texture to the renderer at position x, y with the specified width and height.
@@ -65,7 +190,7 @@ public:
     void renderTexture(SDL_Texture *tex, int x, int y, int w, int h, const SDL_Rect *clip = nullptr, double angle = 0.0, SDL_Point* center = nullptr, SDL_RendererFlip flip = SDL_FLIP_NONE) {
         //Setup the destination rectangle to be at the position we want
         SDL_Rect dst = {.x = x, .y = y, .w = w, .h = h};
-        SDL_RenderCopyEx(renderer, tex, clip, &dst, angle, center, flip);
+        canvas.batch->add(tex, clip, dst, angle, center, flip);
     }
 
     /// Draw an SDL_Texture to the renderer at position x, y, scaling the texture's width and height accordingly.
@@ -81,66 +206,181 @@ public:
         }
         else
             SDL_QueryTexture(tex, nullptr, nullptr, &w, &h);
-        x = static_cast<int>(x * scale) + x_offset;
-        y = static_cast<int>(y * scale);
-        w = static_cast<int>(w * scale);
-        h = static_cast<int>(h * scale);
+        x = static_cast<int>(x * canvas.scale) + canvas.x_offset;
+        y = static_cast<int>(y * canvas.scale) + canvas.y_offset;
+        w = static_cast<int>(w * canvas.scale);
+        h = static_cast<int>(h * canvas.scale);
         renderTexture(tex, x, y, w, h, clip, angle, center, flip);
     }
 
+    /// Draw a whole atlas region to the renderer at position x, y, scaling the region's width and height accordingly.
+    /// \param region The source region we want to draw.
+    /// \param x The x coordinate to draw to.
+    /// \param y The y coordinate to draw to.
+    void renderTexture(const TextureRegion &region, int x, int y, SDL_RendererFlip flip = SDL_FLIP_NONE) {
+        renderTexture(region.texture, x, y, &region.rect, 0.0, nullptr, flip);
+    }
+
+    /// Draws the HUD: shots, ducks hit, round and score.
+    /// The HUD is cached on a texture and only redrawn when the stats it shows change.
     void renderUI(double deltaTime, Textures* textures, Player_Stats *player_stats) {
+        HUDState state{};
+        state.textures = textures;
+        state.shots_left = player_stats->shots_left;
+        state.ducks_hit = player_stats->ducks_hit;
+        state.ducks_current = player_stats->ducks_current & ((1u << state.ducks_hit.size()) - 1);
+        state.ducks_needed = player_stats->ducks_needed;
+        state.round = player_stats->round;
+        state.score = player_stats->score;
+        state.isFlickering = isFlickering;
+
+        if (flickerTimer.tick(deltaTime))
+            isFlickering = !isFlickering;
+
+        if (!renderCachedUI(state))
+            drawUI(state);
+    }
+
+    /// Marks the cached HUD as out of date, e.g. after the renderer lost its render targets.
+    void invalidateUI() {
+        hudValid = false;
+    }
+
+    void worldPointToScreenPoint(int* x, int* y) {
+        double screenX, screenY;
+        if (nativeTarget != nullptr) {
+            int w, h;
+            SDL_QueryTexture(nativeTarget, nullptr, nullptr, &w, &h);
+            screenX = (*x + canvas.x_offset) * static_cast<double>(nativeDestination.w) / w + nativeDestination.x;
+            screenY = *y * static_cast<double>(nativeDestination.h) / h + nativeDestination.y;
+        }
+        else {
+            screenX = *x * scale + x_offset;
+            screenY = *y * scale;
+        }
+
+        *x = static_cast<int>(std::lround(screenX));
+        *y = static_cast<int>(std::lround(screenY));
+    }
+
+    void screenPointToWorldPoint(int* x, int* y) {
+        double screenX, screenY;
+        if (nativeTarget != nullptr) {
+            int w, h;
+            SDL_QueryTexture(nativeTarget, nullptr, nullptr, &w, &h);
+            screenX = (*x - nativeDestination.x) * static_cast<double>(w) / nativeDestination.w - canvas.x_offset;
+            screenY = (*y - nativeDestination.y) * static_cast<double>(h) / nativeDestination.h;
+        }
+        else {
+            screenX = (*x  - x_offset) / scale;
+            screenY = *y / scale;
+        }
+
+        *x = static_cast<int>(screenX);
+        *y = static_cast<int>(screenY);
+    }
+
+private:
+    /// Sets up drawing the visible part of the world 1:1 onto a texture, falling back to drawing straight to the
+    /// window if the renderer can not render to textures.
+    void createNativeTarget(int world_height, int window_height, bool integerScaling) {
+        auto left = static_cast<int>(std::floor(worldLeft()));
+        auto width = static_cast<int>(std::ceil(worldRight())) - left;
+        nativeTarget = createTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, width, world_height);
+        if (nativeTarget == nullptr) {
+            logSDLError(std::cout, "CreateTexture native resolution");
+            return;
+        }
+
+        float upscale = scale;
+        if (integerScaling)
+            upscale = std::max(1.0f, std::floor(scale));
+        nativeDestination.w = static_cast<int>(width * upscale);
+        nativeDestination.h = static_cast<int>(world_height * upscale);
+        nativeDestination.x = (window_width - nativeDestination.w) / 2;
+        nativeDestination.y = (window_height - nativeDestination.h) / 2;
+        canvas = {&batch, 1.0f, -left, 0};
+    }
+
+    /// Draws the HUD texture, redrawing it first if it is out of date.
+    /// \return false if the renderer does not support render targets, and nothing was drawn.
+    bool renderCachedUI(const HUDState &state) {
+        if (!hudSupported)
+            return false;
+        if (hudTexture == nullptr) {
+            hudTexture = createTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, hudBounds.w, hudBounds.h);
+            if (hudTexture == nullptr) {
+                logSDLError(std::cout, "CreateTexture HUD");
+                hudSupported = false;
+                return false;
+            }
+            SDL_SetTextureBlendMode(hudTexture, SDL_BLENDMODE_BLEND);
+        }
+
+        if (!hudValid || !(state == hudState)) {
+            SDL_Texture* previousTarget = SDL_GetRenderTarget(renderer);
+            if (SDL_SetRenderTarget(renderer, hudTexture) != 0) {
+                logSDLError(std::cout, "SetRenderTarget HUD");
+                hudSupported = false;
+                return false;
+            }
+            SDL_SetRenderDrawColor(renderer, 0, 0, 0, SDL_ALPHA_TRANSPARENT);
+            SDL_RenderClear(renderer);
+            SDL_SetRenderDrawColor(renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
+
+            Canvas previous = canvas;
+            canvas = {&hudBatch, 1.0f, -hudBounds.x, -hudBounds.y};
+            drawUI(state);
+            hudBatch.flush(renderer);
+            canvas = previous;
+
+            SDL_SetRenderTarget(renderer, previousTarget);
+            hudState = state;
+            hudValid = true;
+        }
+
+        SDL_Rect source = {0, 0, hudBounds.w, hudBounds.h};
+        renderTexture(hudTexture, hudBounds.x, hudBounds.y, &source);
+        return true;
+    }
+
+    void drawUI(const HUDState &state) {
+        const Textures* textures = state.textures;
+
         // Draw the shots left
         renderTexture(textures->ui_shot, 110, 217);
-        if (player_stats->shots_left >= 3)
+        if (state.shots_left >= 3)
             renderTexture(textures->ui_bullet, 127, 208);
-        if (player_stats->shots_left >= 2)
+        if (state.shots_left >= 2)
             renderTexture(textures->ui_bullet, 119, 208);
-        if (player_stats->shots_left >= 1)
+        if (state.shots_left >= 1)
             renderTexture(textures->ui_bullet, 111, 208);
 
         // Draw the shots left
         renderTexture(textures->ui_hit, 149, 209);
 
         // Draw duck icons
-        bool flickerTicked = flickerTimer.tick(deltaTime);
-        bool isCurrentDuck;
-        for (int i = 0; i < player_stats->ducks_hit.size(); ++i) {
-            isCurrentDuck = std::find(player_stats->ducks_current.begin(), player_stats->ducks_current.end(), i) != player_stats->ducks_current.end();
-            if (player_stats->ducks_hit[i])
+        for (int i = 0; i < state.ducks_hit.size(); ++i) {
+            bool isCurrentDuck = (state.ducks_current & (1u << i)) != 0;
+            if (state.ducks_hit[i])
                 renderTexture(textures->ui_duck_lit, 181 + i * 8, 210);
-            else if (!isCurrentDuck || isFlickering)
+            else if (!isCurrentDuck || state.isFlickering)
                 renderTexture(textures->ui_duck_white, 181 + i * 8, 210);
         }
-        if (flickerTicked)
-            isFlickering = !isFlickering;
 
         // Draw ducks needed bar
-        for (int i = 0; i < player_stats->ducks_needed; ++i)
+        for (int i = 0; i < state.ducks_needed; ++i)
             renderTexture(textures->ui_ducks_needed_bar, 181 + i * 8, 219);
 
         // Draw round counter
-        std::string round_string = std::to_string(player_stats->round);
+        roundLabel.set(&textures->font_green, state.round);
         renderTexture(textures->ui_round, 109, 192);
-        for (int i = 0; i < round_string.size(); ++i)
-            renderCharacter(textures->ui_numbers_green, round_string[i], 124 + i * 8, 192);
-
-        // Draw score
-        std::string score_string = std::to_string(player_stats->score);
-        if (score_string.size() <= 6)
-            score_string.insert(0, 6 - score_string.size(), '0');
-        std::reverse(score_string.begin(), score_string.end());
-        renderTexture(textures->ui_score, 285, 216);
-        for (int i = 0; i < score_string.size(); ++i)
-            renderCharacter(textures->ui_numbers_white, score_string[i], 317 - i * 8, 208);
+        renderNumber(roundLabel, 124, 192);
 
-    }
-
-    void screenPointToWorldPoint(int* x, int* y) {
-        double screenX = (*x  - x_offset) / scale;
-        double screenY = *y / scale;
-
-        *x = static_cast<int>(screenX);
-        *y = static_cast<int>(screenY);
+        // Draw score, right aligned so the last digit is at 317
+        scoreLabel.set(&textures->font_white, state.score);
+        renderTexture(textures->ui_score, 285, 216);
+        renderNumber(scoreLabel, 317 + textures->font_white.advance - scoreLabel.width(), 208);
     }
 };
 
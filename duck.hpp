@@ -1,9 +1,10 @@
 #ifndef DUCKHUNT_DUCK_HPP
 #define DUCKHUNT_DUCK_HPP
 
+#include <algorithm>
 #include <random>
 #include <array>
-#include <utility>
+#include <cstdint>
 #include "textures.hpp"
 #include "timer.hpp"
 #include "drawing.hpp"
@@ -12,11 +13,39 @@
 enum DuckColours { NO_COLOUR, BLUE, BROWN, RED };
 const double pi = std::acos(-1);
 
+/// How a duck looked in a frame that was drawn, to test shots against what the player saw.
+/// Kept small, as every duck remembers Duck::shownHistory of them.
+struct ShownDuck {
+    /// The game time the frame was drawn at in ms.
+    double time;
+    /// The world position, which fits in 16 bits with room to spare.
+    int16_t x;
+    int16_t y;
+    bool flipped;
+    Playhead playhead;
+};
+
+/// The clips a duck of one colour plays.
+struct DuckClips {
+    ClipId dead;
+    ClipId falling;
+    ClipId flyDiagonal;
+    ClipId flyHorizontal;
+    ClipId flyVertical;
+};
+
 class Duck {
 public:
+    /// The number of drawn frames a duck remembers, enough for clicks handled up to 100 ms late at 60 Hz. Older clicks
+    /// are tested against the oldest frame.
+    static constexpr int shownHistory = 6;
+
     int index;
     double x;
     double y;
+    /// The position at the start of the last simulation step, drawing interpolates from here to x, y.
+    double previousX;
+    double previousY;
     bool alive;
     DuckColours colour;
 private:
@@ -24,10 +53,13 @@ private:
     int xDied;
     int yDied;
     int score;
-    double angle;
+    /// The cosine and sine of the direction the duck flies in, where 0 is right and pi / 2 is up. The direction only
+    /// changes when the duck bounces, so they are worked out then rather than every step.
+    double cosAngle;
+    double sinAngle;
     double speed;
-    SDL_Texture* scoreTexture;
-    SDL_Rect scoreFrame;
+    SpriteStrip scoreStrip;
+    int scoreFrame;
     Timer lifeTimer;
 
     // animation
@@ -35,60 +67,62 @@ private:
     bool isFreeOfBush;
     bool stayOnScreen;
     Timer deadTimer;
-    Animation* current = nullptr;
-    Animation dead;
-    Animation falling;
-    Animation flyDiagonal;
-    Animation flyHorizontal;
-    Animation flyVertical;
+    const Textures* textures;
+    DuckClips clips;
+    Playhead playhead;
+    double frameLength;
 
     double scaledLeftBoundary;
     double scaledRightBoundary;
 
+    /// The last frames drawn, oldest first from ::shownNext once the history is full.
+    std::array<ShownDuck, shownHistory> shown;
+    int shownCount;
+    int shownNext;
+
 public:
     Duck(int index, DuckColours colour, int spawn_x, int spawn_y, double speed, int score, int framesPerSecond,
-         Animation dead, Animation falling, Animation flyDiagonal, Animation flyHorizontal, Animation flyVertical,
-         double scaledLeftBoundary, double scaledRightBoundary, SDL_Texture* scoreTexture, SDL_Rect scoreFrame,
-         std::mt19937* mt) : dead(std::move(dead)), falling(std::move(falling)), flyDiagonal(std::move(flyDiagonal)),
-                             flyHorizontal(std::move(flyHorizontal)), flyVertical(std::move(flyVertical)),
-                             scoreFrame(scoreFrame), deadTimer(500), lifeTimer(10000) {
+         const Textures* textures, DuckClips clips, double scaledLeftBoundary, double scaledRightBoundary,
+         SpriteStrip scoreStrip, int scoreFrame, std::mt19937* mt)
+         : scoreStrip(scoreStrip), scoreFrame(scoreFrame), lifeTimer(10000), deadTimer(500) {
         this->mt = mt;
         this->index = index;
         this->colour = colour;
         x = spawn_x;
         y = spawn_y;
+        previousX = x;
+        previousY = y;
         xDied = 0;
         yDied = 0;
         this->speed = speed;
-        angle = randAngle(pi / 4.0, 3.0 * pi / 4.0);
+        setAngle(randAngle(pi / 4.0, 3.0 * pi / 4.0));
         this->score = score;
         stayOnScreen = true;
         isFreeOfBush = false;
         deadTimer.disable();
-        this->dead.reset(framesPerSecond);
-        this->falling.reset(framesPerSecond);
-        this->flyDiagonal.reset(framesPerSecond);
-        this->flyHorizontal.reset(framesPerSecond);
-        this->flyVertical.reset(framesPerSecond);
+        this->textures = textures;
+        this->clips = clips;
+        playhead = {clips.flyDiagonal, 0, 0.0f};
+        frameLength = 1000.0 / framesPerSecond;
         this->scaledLeftBoundary = scaledLeftBoundary;
         this->scaledRightBoundary = scaledRightBoundary;
         alive = true;
-        this->scoreTexture = scoreTexture;
-        std::cout << "Spawning a new duck" << std::endl;
+        shownCount = 0;
+        shownNext = 0;
     }
 
     void update(double deltaTime) {
         double new_x, new_y;
         double newAngle = std::numeric_limits<double>::infinity();
 
-        new_x = x + std::cos(angle) * speed * deltaTime;
-        new_y = y - std::sin(angle) * speed * deltaTime;
+        new_x = x + cosAngle * speed * deltaTime;
+        new_y = y - sinAngle * speed * deltaTime;
 
         // Bounce duck on screen edge
         if (alive) {
             if (stayOnScreen && new_y < 0) // top
                 newAngle = randAngle(7.0 * pi / 6.0, 11.0 * pi / 6.0);
-            if (new_y > 155 - dead.frameHeight()) { // bottom
+            if (new_y > 155 - height()) { // bottom
                 if (isFreeOfBush)
                     newAngle = randAngle(pi / 4.0, 3.0 * pi / 4.0);
             }
@@ -101,14 +135,14 @@ public:
 
             // Apply new angle or position
             if (!std::isinf(newAngle)) {
-                angle = newAngle;
+                setAngle(newAngle);
                 // Set duck's animation according to its angle
-                new_x = std::abs(std::cos(angle));
-                new_y = std::abs(std::sin(angle));
+                new_x = std::abs(cosAngle);
+                new_y = std::abs(sinAngle);
                 if (new_x > new_y)
-                    current = &flyHorizontal;
+                    playhead.play(clips.flyHorizontal);
                 else
-                    current = &flyDiagonal;
+                    playhead.play(clips.flyDiagonal);
             }
         }
         // Move duck
@@ -118,40 +152,79 @@ public:
         }
     }
 
+    /// Remembers the current position as the start of a simulation step, call before ::update(double deltaTime).
+    void storePosition() {
+        previousX = x;
+        previousY = y;
+    }
+
     bool canDuckEscape(double deltaTime) {
         return lifeTimer.tick(deltaTime);
     }
 
-    void render(Drawer* drawer, double deltaTime) {
-        // TODO: I can't initialise current in the constructor?
-        if (current == nullptr)
-            current = &this->flyDiagonal;
+    /// Draws the duck.
+    /// \param drawer The drawer to render with.
+    /// \param deltaTime The time since the last frame in ms.
+    /// \param interpolation How far to draw the duck between its previous and current position, from 0 to 1.
+    void render(Drawer* drawer, double deltaTime, double interpolation = 1.0) {
+        animate(deltaTime);
+
+        // The texture is flipped when going left
+        ShownDuck state = shownState(0.0, interpolation);
+        SDL_RendererFlip flip = state.flipped ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE;
+        SDL_Rect frame = playhead.rect(textures);
+        drawer->renderTexture(playhead.texture(textures), state.x, state.y, &frame, 0.0, nullptr, flip);
+    }
+
+    /// Remembers how the duck was last drawn, call after ::render(Drawer* drawer, double deltaTime, double interpolation)
+    /// for ducks that can be shot.
+    /// \param time The game time of the frame in ms.
+    /// \param interpolation The interpolation the duck was drawn with.
+    void rememberShown(double time, double interpolation) {
+        shown[shownNext] = shownState(time, interpolation);
+        shownNext = (shownNext + 1) % shownHistory;
+        shownCount = std::min(shownCount + 1, shownHistory);
+    }
+
+    /// How the duck was on screen at a time: the last frame drawn by then, or the oldest frame remembered for times
+    /// before it.
+    /// \param time The game time in ms.
+    /// \return nullptr if no frame of the duck has been remembered yet.
+    const ShownDuck* shownAt(double time) const {
+        if (shownCount == 0)
+            return nullptr;
+        int oldest = (shownNext - shownCount + shownHistory) % shownHistory;
+        for (int i = 1; i <= shownCount; ++i) {
+            const ShownDuck &state = shown[(shownNext - i + shownHistory) % shownHistory];
+            if (state.time <= time)
+                return &state;
+        }
+        return &shown[oldest];
+    }
 
-        // Select next frame
+    /// Moves the duck's animation on, and starts a dead duck falling once it has hung in the air for long enough.
+    /// Called by ::render(Drawer* drawer, double deltaTime, double interpolation), or on its own to play without drawing.
+    /// \param deltaTime The time since the last frame in ms.
+    void animate(double deltaTime) {
         if (deadTimer.tick(deltaTime)) {
-            current = &falling;
+            playhead.play(clips.falling);
             deadTimer.disable();
-            speed = 0.05;
+            speed = 0.1;
         }
-
-        // Flip texture if going left
-        SDL_RendererFlip flip = SDL_FLIP_NONE;
-        if (std::cos(angle) < 0.0)
-            flip = SDL_FLIP_HORIZONTAL;
-
-        drawer->renderTexture(current->texture, static_cast<int>(x), static_cast<int>(y), current->advance(deltaTime), 0.0, nullptr, flip);
+        playhead.advance(deltaTime, frameLength);
     }
 
     void renderScore(Drawer* drawer) {
-        drawer->renderTexture(scoreTexture, xDied, yDied, &scoreFrame);
+        SDL_Rect frame = scoreStrip.frame(scoreFrame);
+        drawer->renderTexture(scoreStrip.texture(), xDied, yDied, &frame);
     }
 
     int kill() {
         alive = false;
         deadTimer.enable();
-        current = &dead;
+        playhead.play(clips.dead);
         speed = 0.0;
-        angle = 3.0 * pi / 2.0;
+        setAngle(3.0 * pi / 2.0);
         xDied = static_cast<int>(x);
         yDied = static_cast<int>(y);
         return score;
@@ -159,8 +232,8 @@ public:
 
     void flyUp() {
         stayOnScreen = false;
-        angle = pi / 2.0;
-        current = &flyVertical;
+        setAngle(pi / 2.0);
+        playhead.play(clips.flyVertical);
     }
 
     void flyAway() {
@@ -180,18 +253,72 @@ public:
     /// Checks whether the duck has died and is falling back to the ground.
     /// \return true if falling, false otherwise.
     bool isFalling() {
-        return !alive && current == &falling;
+        return !alive && playhead.clip == clips.falling;
+    }
+
+    /// Whether a point is on one of the opaque pixels of the frame the duck is showing.
+    /// \param worldX The x coordinate of the point in the world.
+    /// \param worldY The y coordinate of the point in the world.
+    bool hits(int worldX, int worldY) {
+        return stripHit(textures, clipStrip(textures, playhead.clip), playhead.frame, cosAngle < 0.0,
+                        worldX - static_cast<int>(x), worldY - static_cast<int>(y));
+    }
+
+    /// Whether a point was on one of the opaque pixels of the duck as it was on screen at a time, testing against the
+    /// duck as it is now if it has not been drawn.
+    /// \param time The game time in ms.
+    bool hitsShown(double time, int worldX, int worldY) const {
+        const ShownDuck* state = shownAt(time);
+        if (state == nullptr)
+            return stripHit(textures, clipStrip(textures, playhead.clip), playhead.frame, cosAngle < 0.0,
+                            worldX - static_cast<int>(x), worldY - static_cast<int>(y));
+        return stripHit(textures, clipStrip(textures, state->playhead.clip), state->playhead.frame, state->flipped,
+                        worldX - state->x, worldY - state->y);
+    }
+
+    /// The area the duck covered on screen at a time, or covers now if it has not been drawn.
+    /// \param time The game time in ms.
+    SDL_Rect shownBounds(double time) {
+        const ShownDuck* state = shownAt(time);
+        if (state == nullptr)
+            return {static_cast<int>(x), static_cast<int>(y), width(), height()};
+        return {state->x, state->y, width(), height()};
+    }
+
+    /// The area the duck covers from where it was shown in the remembered frames to where it is now, which holds
+    /// every point ::hits(int worldX, int worldY) and ::hitsShown(double time, int worldX, int worldY) can hit.
+    SDL_Rect shownSpan() {
+        int left = static_cast<int>(std::min(x, previousX)), right = static_cast<int>(std::max(x, previousX));
+        int top = static_cast<int>(std::min(y, previousY)), bottom = static_cast<int>(std::max(y, previousY));
+        for (int i = 0; i < shownCount; ++i) {
+            left = std::min<int>(left, shown[i].x);
+            right = std::max<int>(right, shown[i].x);
+            top = std::min<int>(top, shown[i].y);
+            bottom = std::max<int>(bottom, shown[i].y);
+        }
+        return {left, top, right - left + width(), bottom - top + height()};
     }
 
     int width() {
-        return dead.frameWidth();
+        return clipStrip(textures, clips.dead).frameWidth();
     }
 
     int height() {
-        return dead.frameHeight();
+        return clipStrip(textures, clips.dead).frameHeight();
     }
 
 private:
+    ShownDuck shownState(double time, double interpolation) const {
+        double drawX = previousX + (x - previousX) * interpolation;
+        double drawY = previousY + (y - previousY) * interpolation;
+        return {time, static_cast<int16_t>(drawX), static_cast<int16_t>(drawY), cosAngle < 0.0, playhead};
+    }
+
+    void setAngle(double angle) {
+        cosAngle = std::cos(angle);
+        sinAngle = std::sin(angle);
+    }
+
     double randAngle(double min, double max)
     {
         std::uniform_real_distribution<double> dist(min, max);
@@ -206,111 +333,77 @@ public:
     const int spawnXLow = 133;
     const int spawnXHigh = 272;
 private:
-    std::random_device rd;
-    std::mt19937 mt;
-    Animation blueDead;
-    Animation blueFalling;
-    Animation blueFlyingDiagonal;
-    Animation blueFlyingHorizontal;
-    Animation blueFlyingVertical;
-    Animation brownDead;
-    Animation brownFalling;
-    Animation brownFlyingDiagonal;
-    Animation brownFlyingHorizontal;
-    Animation brownFlyingVertical;
-    Animation redDead;
-    Animation redFalling;
-    Animation redFlyingDiagonal;
-    Animation redFlyingHorizontal;
-    Animation redFlyingVertical;
-    std::vector<SDL_Rect> duckScoreFrames;
-    SDL_Texture* duckScoreTexture;
+    std::mt19937* mt;
+    const Textures* textures;
+    SpriteStrip duckScore;
 
     double scaledLeftBoundary;
     double scaledRightBoundary;
 
 public:
-    DuckHatchery(Textures* textures, Drawer* drawer)
-        : blueDead(textures->duck_blue_dead, 1), blueFalling(textures->duck_blue_falling, 4),
-          blueFlyingDiagonal(textures->duck_blue_diagonal, 3), blueFlyingHorizontal(textures->duck_blue_horizontal, 3),
-          blueFlyingVertical(textures->duck_blue_vertical, 3),
-          brownDead(textures->duck_brown_dead, 1), brownFalling(textures->duck_brown_falling, 4),
-          brownFlyingDiagonal(textures->duck_brown_diagonal, 3), brownFlyingHorizontal(textures->duck_brown_horizontal, 3),
-          brownFlyingVertical(textures->duck_brown_vertical, 3),
-          redDead(textures->duck_red_dead, 1), redFalling(textures->duck_red_falling, 4),
-          redFlyingDiagonal(textures->duck_red_diagonal, 3), redFlyingHorizontal(textures->duck_red_horizontal, 3),
-          redFlyingVertical(textures->duck_red_vertical, 3) {
-        mt = std::mt19937(rd());
-        duckScoreTexture = textures->duck_score;
-        duckScoreFrames = spriteStripRects(duckScoreTexture, 8);
-
-        scaledLeftBoundary = -drawer->x_offset / drawer->scale;
-        scaledRightBoundary = drawer->window_width / drawer->scale + scaledLeftBoundary - blueDead.frameWidth();
+    /// \param textures The textures of the ducks.
+    /// \param drawer The drawer, used to find the edges of the screen.
+    /// \param mt The random number generator for spawn points and flight paths.
+    DuckHatchery(Textures* textures, Drawer* drawer, std::mt19937* mt) {
+        this->mt = mt;
+        this->textures = textures;
+        duckScore = {&textures->duck_score, 8};
+
+        scaledLeftBoundary = drawer->worldLeft();
+        scaledRightBoundary = drawer->worldRight() - clipStrip(textures, CLIP_DUCK_BLUE_DEAD).frameWidth();
     }
 
-    Duck newDuck(DuckColours duck_colour, int score, int round, int duckIndex) {
-        Animation* dead;
-        Animation* falling;
-        Animation* flyDiagonal;
-        Animation* flyHorizontal;
-        Animation* flyVertical;
-        SDL_Rect* scoreFrame;
-        switch (duck_colour) {
+    /// The clips played by a duck of a colour.
+    static DuckClips clipsForColour(DuckColours colour) {
+        switch (colour) {
             case BLUE:
-                dead = &blueDead;
-                falling = &blueFalling;
-                flyDiagonal = &blueFlyingDiagonal;
-                flyHorizontal = &blueFlyingHorizontal;
-                flyVertical = &blueFlyingVertical;
-                break;
+                return {CLIP_DUCK_BLUE_DEAD, CLIP_DUCK_BLUE_FALLING, CLIP_DUCK_BLUE_DIAGONAL, CLIP_DUCK_BLUE_HORIZONTAL,
+                        CLIP_DUCK_BLUE_VERTICAL};
             case RED:
-                dead = &redDead;
-                falling = &redFalling;
-                flyDiagonal = &redFlyingDiagonal;
-                flyHorizontal = &redFlyingHorizontal;
-                flyVertical = &redFlyingVertical;
-                break;
+                return {CLIP_DUCK_RED_DEAD, CLIP_DUCK_RED_FALLING, CLIP_DUCK_RED_DIAGONAL, CLIP_DUCK_RED_HORIZONTAL,
+                        CLIP_DUCK_RED_VERTICAL};
             default:
-                dead = &brownDead;
-                falling = &brownFalling;
-                flyDiagonal = &brownFlyingDiagonal;
-                flyHorizontal = &brownFlyingHorizontal;
-                flyVertical = &brownFlyingVertical;
-                break;
+                return {CLIP_DUCK_BROWN_DEAD, CLIP_DUCK_BROWN_FALLING, CLIP_DUCK_BROWN_DIAGONAL, CLIP_DUCK_BROWN_HORIZONTAL,
+                        CLIP_DUCK_BROWN_VERTICAL};
         }
+    }
+
+    Duck newDuck(DuckColours duck_colour, int score, int round, int duckIndex) {
+        int scoreFrame;
         switch (score) {
             default:
-                scoreFrame = &duckScoreFrames[0];
+                scoreFrame = 0;
                 break;
             case 800:
-                scoreFrame = &duckScoreFrames[1];
+                scoreFrame = 1;
                 break;
             case 1000:
-                scoreFrame = &duckScoreFrames[2];
+                scoreFrame = 2;
                 break;
             case 1500:
-                scoreFrame = &duckScoreFrames[3];
+                scoreFrame = 3;
                 break;
             case 1600:
-                scoreFrame = &duckScoreFrames[4];
+                scoreFrame = 4;
                 break;
             case 2000:
-                scoreFrame = &duckScoreFrames[5];
+                scoreFrame = 5;
                 break;
             case 2400:
-                scoreFrame = &duckScoreFrames[6];
+                scoreFrame = 6;
                 break;
             case 3000:
-                scoreFrame = &duckScoreFrames[7];
+                scoreFrame = 7;
                 break;
         }
 
-        double speed = 0.05 + 0.01 * round;
+        // Twice the speeds the ducks were first tuned at, when the game moved them twice a step
+        double speed = 2.0 * (0.05 + 0.01 * round);
         std::uniform_int_distribution<int> dist(spawnXLow, spawnXHigh);
-        int spawn_x = dist(mt);
+        int spawn_x = dist(*mt);
         int spawn_y = spawnY;
-        return {duckIndex, duck_colour, spawn_x, spawn_y, speed, score, 10 + round, *dead, *falling, *flyDiagonal,
-            *flyHorizontal, *flyVertical, scaledLeftBoundary, scaledRightBoundary, duckScoreTexture, *scoreFrame, &mt};
+        return {duckIndex, duck_colour, spawn_x, spawn_y, speed, score, 10 + round, textures, clipsForColour(duck_colour),
+            scaledLeftBoundary, scaledRightBoundary, duckScore, scoreFrame, mt};
     }
 };
 
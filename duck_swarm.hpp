@@ -0,0 +1,276 @@
+#ifndef DUCKHUNT_DUCK_SWARM_HPP
+#define DUCKHUNT_DUCK_SWARM_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "SDL2/SDL.h"
+#include "drawing.hpp"
+#include "duck.hpp"
+#include "spatial_grid.hpp"
+#include "textures.hpp"
+
+/// A large number of flying ducks, stored as parallel arrays rather than as Ducks.
+/// Ducks fly in straight lines at a stored velocity, so moving them is a multiply-add. The edge tests are done for
+/// every duck in one branch-free loop the compiler can vectorise, and only the ducks that hit an edge pick a new
+/// direction with trigonometry.
+class DuckSwarm {
+private:
+    enum Heading : uint8_t {HORIZONTAL, DIAGONAL};
+    /// Bits for the edges a duck hit in the last update.
+    enum Edge : uint8_t {LEFT = 1, RIGHT = 2, TOP = 4, BOTTOM = 8};
+    static constexpr int flyingFrames = 3;
+
+    // One entry per duck
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> previousX;
+    std::vector<float> previousY;
+    std::vector<float> velocityX;
+    std::vector<float> velocityY;
+    std::vector<float> frameTime;
+    std::vector<uint8_t> frame;
+    std::vector<uint8_t> colour;
+    std::vector<uint8_t> heading;
+    /// The Edge bits of the edges each duck hit in the last update.
+    std::vector<uint8_t> bounce;
+
+    /// The strips of each colour and heading, indexed by DuckColours then Heading.
+    std::array<std::array<SpriteStrip, 2>, 4> strips{};
+    const Textures* textures;
+    /// The ducks by where they are, rebuilt whenever they move or are added or removed.
+    SpatialGrid grid;
+    std::mt19937* mt;
+    float left;
+    float right;
+    float top;
+    float bottom;
+    float speed;
+    float frameLength;
+    /// The width and height of the largest frame of any strip, which every duck is listed in the grid by.
+    int frameSize;
+
+public:
+    /// \param textures The textures of the ducks.
+    /// \param drawer The drawer, used to find the edges of the screen.
+    /// \param mt The random number generator for spawn points and flight paths.
+    /// \param speed How fast the ducks fly in pixels per ms.
+    DuckSwarm(Textures* textures, Drawer* drawer, std::mt19937* mt, double speed = 0.06)
+        : grid(gridArea(drawer), 16) {
+        this->textures = textures;
+        this->mt = mt;
+        this->speed = static_cast<float>(speed);
+        frameLength = 1000.0f / 10.0f;
+        strips[BLUE] = {{{&textures->duck_blue_horizontal, flyingFrames}, {&textures->duck_blue_diagonal, flyingFrames}}};
+        strips[BROWN] = {{{&textures->duck_brown_horizontal, flyingFrames}, {&textures->duck_brown_diagonal, flyingFrames}}};
+        strips[RED] = {{{&textures->duck_red_horizontal, flyingFrames}, {&textures->duck_red_diagonal, flyingFrames}}};
+        strips[NO_COLOUR] = strips[BROWN];
+        frameSize = 0;
+        for (auto &headings : strips)
+            for (auto &strip : headings)
+                frameSize = std::max(frameSize, std::max(strip.frameWidth(), strip.frameHeight()));
+
+        int size = textures->duck_blue_dead.rect.w;
+        left = static_cast<float>(drawer->worldLeft());
+        right = static_cast<float>(drawer->worldRight()) - size;
+        top = 0.0f;
+        bottom = 155.0f - size;
+    }
+
+    size_t size() const {
+        return x.size();
+    }
+
+    /// Adds ducks at random points in the sky, flying in random directions.
+    /// \param count The number of ducks to add.
+    void spawn(size_t count) {
+        std::uniform_real_distribution<float> spawnX(left, right);
+        std::uniform_real_distribution<float> spawnY(top, bottom);
+        std::uniform_int_distribution<int> spawnColour(0, 10);
+        std::uniform_real_distribution<double> spawnAngle(0.0, 2.0 * pi);
+        reserve(size() + count);
+        for (size_t i = 0; i < count; ++i) {
+            float duckX = spawnX(*mt);
+            float duckY = spawnY(*mt);
+            x.push_back(duckX);
+            y.push_back(duckY);
+            previousX.push_back(duckX);
+            previousY.push_back(duckY);
+            velocityX.push_back(0.0f);
+            velocityY.push_back(0.0f);
+            frameTime.push_back(0.0f);
+            frame.push_back(static_cast<uint8_t>(i % flyingFrames));
+            int colourRandom = spawnColour(*mt);
+            colour.push_back(colourRandom < 1 ? RED : colourRandom < 5 ? BLUE : BROWN);
+            heading.push_back(HORIZONTAL);
+            bounce.push_back(0);
+            setAngle(size() - 1, spawnAngle(*mt));
+        }
+        rebuildGrid();
+    }
+
+    /// Removes a duck, moving the last duck into its place.
+    void remove(size_t index) {
+        size_t last = size() - 1;
+        x[index] = x[last];
+        y[index] = y[last];
+        previousX[index] = previousX[last];
+        previousY[index] = previousY[last];
+        velocityX[index] = velocityX[last];
+        velocityY[index] = velocityY[last];
+        frameTime[index] = frameTime[last];
+        frame[index] = frame[last];
+        colour[index] = colour[last];
+        heading[index] = heading[last];
+        bounce[index] = bounce[last];
+        x.pop_back();
+        y.pop_back();
+        previousX.pop_back();
+        previousY.pop_back();
+        velocityX.pop_back();
+        velocityY.pop_back();
+        frameTime.pop_back();
+        frame.pop_back();
+        colour.pop_back();
+        heading.pop_back();
+        bounce.pop_back();
+        rebuildGrid();
+    }
+
+    /// Moves every duck by one simulation step, bouncing them off the edges of the sky.
+    /// \param deltaTime The length of the step in ms.
+    void update(double deltaTime) {
+        const size_t count = size();
+        const float dt = static_cast<float>(deltaTime);
+        std::copy(x.begin(), x.end(), previousX.begin());
+        std::copy(y.begin(), y.end(), previousY.begin());
+
+        // Move and test every duck against the edges without branches, so the loop vectorises
+        float* px = x.data();
+        float* py = y.data();
+        const float* vx = velocityX.data();
+        const float* vy = velocityY.data();
+        uint8_t* edge = bounce.data();
+        const float minX = left, maxX = right, minY = top, maxY = bottom;
+        int anyBounced = 0;
+        for (size_t i = 0; i < count; ++i) {
+            float oldX = px[i], oldY = py[i], dx = vx[i] * dt, dy = vy[i] * dt;
+            float newX = oldX + dx;
+            float newY = oldY + dy;
+            int hitLeft = (newX < minX) & (dx < 0.0f);
+            int hitRight = (newX > maxX) & (dx > 0.0f);
+            int hitTop = (newY < minY) & (dy < 0.0f);
+            int hitBottom = (newY > maxY) & (dy > 0.0f);
+            int hit = hitLeft * LEFT | hitRight * RIGHT | hitTop * TOP | hitBottom * BOTTOM;
+            px[i] = hit != 0 ? oldX : newX;
+            py[i] = hit != 0 ? oldY : newY;
+            edge[i] = static_cast<uint8_t>(hit);
+            anyBounced |= hit;
+        }
+
+        // Only ducks that hit an edge need a new direction
+        if (anyBounced)
+            for (size_t i = 0; i < count; ++i)
+                if (edge[i] != 0)
+                    setAngle(i, bounceAngle(edge[i]));
+
+        // Advance the flapping animations
+        float* time = frameTime.data();
+        uint8_t* frames = frame.data();
+        for (size_t i = 0; i < count; ++i) {
+            time[i] += dt;
+            uint8_t advance = time[i] >= frameLength;
+            time[i] -= advance * frameLength;
+            frames[i] = static_cast<uint8_t>(frames[i] + advance);
+            frames[i] = static_cast<uint8_t>(frames[i] - (frames[i] >= flyingFrames) * flyingFrames);
+        }
+
+        rebuildGrid();
+    }
+
+    /// Draws every duck.
+    /// \param drawer The drawer to render with.
+    /// \param interpolation How far to draw the ducks between their previous and current positions, from 0 to 1.
+    void render(Drawer* drawer, double interpolation = 1.0) {
+        auto t = static_cast<float>(interpolation);
+        for (size_t i = 0; i < size(); ++i) {
+            const SpriteStrip &strip = strips[colour[i]][heading[i]];
+            SDL_Rect rect = strip.frame(frame[i]);
+            int drawX = static_cast<int>(previousX[i] + (x[i] - previousX[i]) * t);
+            int drawY = static_cast<int>(previousY[i] + (y[i] - previousY[i]) * t);
+            drawer->renderTexture(strip.texture(), drawX, drawY, &rect, 0.0, nullptr,
+                                  velocityX[i] < 0.0f ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE);
+        }
+    }
+
+    /// Finds the duck drawn on top at a point, testing against the pixels of its current frame.
+    /// Only the ducks the grid finds near the point are tested.
+    /// \return The duck's index, or -1 if there is no duck there.
+    long hitTest(int worldX, int worldY) const {
+        long hit = -1;
+        grid.forEachNear(worldX, worldY, [&](int duck) {
+            if (duck > hit && stripHit(textures, strips[colour[duck]][heading[duck]], frame[duck], velocityX[duck] < 0.0f,
+                                       worldX - static_cast<int>(x[duck]), worldY - static_cast<int>(y[duck])))
+                hit = duck;
+        });
+        return hit;
+    }
+
+    /// The centre of a duck.
+    void centre(size_t index, int* centreX, int* centreY) const {
+        const SpriteStrip &strip = strips[colour[index]][heading[index]];
+        *centreX = static_cast<int>(x[index]) + strip.frameWidth() / 2;
+        *centreY = static_cast<int>(y[index]) + strip.frameHeight() / 2;
+    }
+
+private:
+    static SDL_Rect gridArea(Drawer* drawer) {
+        auto left = static_cast<int>(drawer->worldLeft());
+        return {left, 0, static_cast<int>(drawer->worldRight()) - left, 155};
+    }
+
+    void reserve(size_t capacity) {
+        for (auto array : {&x, &y, &previousX, &previousY, &velocityX, &velocityY, &frameTime})
+            array->reserve(capacity);
+        for (auto array : {&frame, &colour, &heading, &bounce})
+            array->reserve(capacity);
+        grid.reserve(capacity);
+    }
+
+    void rebuildGrid() {
+        grid.rebuild(size(), [this](size_t i, SDL_Rect* bounds) {
+            *bounds = {static_cast<int>(x[i]), static_cast<int>(y[i]), frameSize, frameSize};
+            return true;
+        });
+    }
+
+    /// A new direction away from the edges a duck hit, in the same ranges Duck uses.
+    double bounceAngle(uint8_t edges) {
+        if (edges & RIGHT)
+            return randAngle(2.0 * pi / 3.0, 4.0 * pi / 3.0);
+        if (edges & LEFT)
+            return std::fmod(randAngle(5.0 * pi / 6.0, 18.0 * pi / 6.0), 2.0 * pi);
+        if (edges & TOP)
+            return randAngle(7.0 * pi / 6.0, 11.0 * pi / 6.0);
+        return randAngle(pi / 4.0, 3.0 * pi / 4.0);
+    }
+
+    /// Points a duck in a direction, where 0 is right and pi / 2 is up.
+    void setAngle(size_t index, double angle) {
+        double cos = std::cos(angle);
+        double sin = std::sin(angle);
+        velocityX[index] = static_cast<float>(cos * speed);
+        velocityY[index] = static_cast<float>(-sin * speed);
+        heading[index] = std::abs(cos) > std::abs(sin) ? HORIZONTAL : DIAGONAL;
+    }
+
+    double randAngle(double min, double max) {
+        std::uniform_real_distribution<double> dist(min, max);
+        return dist(*mt);
+    }
+};
+
+#endif //DUCKHUNT_DUCK_SWARM_HPP
@@ -9,7 +9,7 @@
 * @param os The output stream to write the message to
 * @param msg The error message to write, format will be msg error: SDL_GetError()
 */
-void logSDLError(std::ostream &os, const std::string &msg){
+inline void logSDLError(std::ostream &os, const std::string &msg){
     os << msg << " error: " << SDL_GetError() << std::endl;
 }
 
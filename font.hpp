@@ -0,0 +1,102 @@
+#ifndef DUCKHUNT_FONT_HPP
+#define DUCKHUNT_FONT_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include "SDL2/SDL.h"
+#include "atlas.hpp"
+
+/// A bitmap font made of a strip of the digits 0 to 9, with the rect of each glyph computed once.
+class BitmapFont {
+private:
+    std::array<SDL_Rect, 10> glyphs{};
+
+public:
+    SDL_Texture* texture = nullptr;
+    /// The distance between the left edges of two neighbouring characters.
+    int advance = 8;
+
+    BitmapFont() = default;
+
+    explicit BitmapFont(const TextureRegion &numbers) {
+        texture = numbers.texture;
+        int w = numbers.rect.w / 10;
+        for (int i = 0; i < 10; ++i)
+            glyphs[i] = {numbers.rect.x + i * w, numbers.rect.y, w, numbers.rect.h};
+    }
+
+    /// The rect of a digit.
+    /// \param digit The digit, 0 to 9.
+    const SDL_Rect* glyph(int digit) const {
+        return &glyphs[digit];
+    }
+
+    /// The rect of a character, characters that are not digits are drawn as 0.
+    const SDL_Rect* glyph(char character) const {
+        if (character < '0' || character > '9')
+            return glyph(0);
+        return glyph(character - '0');
+    }
+};
+
+/// A number laid out in the glyphs of a BitmapFont. The layout is only redone when the number changes.
+class NumberLabel {
+private:
+    const BitmapFont* font = nullptr;
+    int value = 0;
+    int minDigits;
+    int length = 0;
+    /// The glyph of each digit, most significant first.
+    std::array<const SDL_Rect*, 10> glyphs{};
+
+public:
+    /// \param minDigits The number is padded with leading zeros to at least this many digits.
+    explicit NumberLabel(int minDigits = 1) {
+        this->minDigits = std::max(1, std::min(minDigits, static_cast<int>(glyphs.size())));
+    }
+
+    /// Sets the number to show, laying it out again only if it, or the font, changed.
+    /// \param font The font to show the number in.
+    /// \param value The number, negative numbers are shown without their sign.
+    void set(const BitmapFont* font, int value) {
+        if (font == this->font && value == this->value && length > 0)
+            return;
+        this->font = font;
+        this->value = value;
+
+        std::array<int, 10> digits{};
+        long magnitude = std::abs(static_cast<long>(value));
+        int count = 0;
+        do {
+            digits[count++] = static_cast<int>(magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude > 0 && count < digits.size());
+        while (count < minDigits)
+            digits[count++] = 0;
+
+        length = count;
+        for (int i = 0; i < length; ++i)
+            glyphs[i] = font->glyph(digits[length - 1 - i]);
+    }
+
+    /// The number of characters in the label.
+    int size() const {
+        return length;
+    }
+
+    /// The width of the label in world pixels.
+    int width() const {
+        return font == nullptr ? 0 : length * font->advance;
+    }
+
+    const BitmapFont* getFont() const {
+        return font;
+    }
+
+    const SDL_Rect* glyph(int i) const {
+        return glyphs[i];
+    }
+};
+
+#endif //DUCKHUNT_FONT_HPP
@@ -0,0 +1,288 @@
+#ifndef DUCKHUNT_FRAME_TIMER_HPP
+#define DUCKHUNT_FRAME_TIMER_HPP
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "SDL2/SDL.h"
+#include "allocations.hpp"
+#include "font.hpp"
+#include "trace.hpp"
+
+/// The parts of a frame that are timed, in the order they run.
+enum FramePhase {
+    PHASE_INPUT,
+    PHASE_UPDATE,
+    PHASE_BACKGROUND,
+    PHASE_FOREGROUND,
+    PHASE_UI,
+    PHASE_PRESENT,
+    PHASE_COUNT
+};
+
+const std::array<const char*, PHASE_COUNT> framePhaseNames = {"input", "update", "background", "foreground", "ui", "present"};
+
+/// The spread of a phase's time over the last frames, in ms.
+struct PhaseStats {
+    double min;
+    double avg;
+    double p99;
+};
+
+/// Times each phase of every frame and keeps rolling statistics over the last ::window frames.
+/// Frames can also be written to a CSV file as they finish, with their allocations when those are tracked.
+class FrameTimer {
+public:
+    /// The number of frames the statistics are taken over.
+    static constexpr int window = 300;
+    /// The number of frames between updates of ::summary(), so an overlay is readable.
+    static constexpr int summaryInterval = 30;
+
+private:
+    /// Times of the last frames, one row per phase and a last row for the whole frame.
+    std::array<std::array<double, window>, PHASE_COUNT + 1> samples{};
+    std::array<PhaseStats, PHASE_COUNT + 1> stats{};
+    std::array<double, PHASE_COUNT> current{};
+    /// Scratch space for finding percentiles, kept here so that summarising does not allocate.
+    std::array<double, window> sorted{};
+    int frames = 0;
+    int next = 0;
+    double lastTotal = 0.0;
+    Uint64 frameStart = 0;
+    Uint64 mark = 0;
+    bool inFrame = false;
+    std::ofstream csv;
+
+public:
+    /// Whether the frame time overlay is drawn.
+    bool overlayVisible = false;
+
+    /// Starts writing a line per frame to a CSV file.
+    /// \param filename The file to write to.
+    /// \return false if the file could not be opened.
+    bool openCSV(const std::string &filename) {
+        csv.open(filename, std::ios::trunc);
+        if (!csv.good())
+            return false;
+        csv << "frame,delta_ms";
+        for (const char* name : framePhaseNames)
+            csv << ',' << name << "_ms";
+        csv << ",total_ms";
+        if (allocationTracking)
+            csv << ",allocations,allocated_bytes";
+        csv << '\n';
+        return true;
+    }
+
+    /// Starts timing a frame, dropping a frame that was started but not finished.
+    void beginFrame() {
+        frameStart = SDL_GetPerformanceCounter();
+        mark = frameStart;
+        current = {};
+        inFrame = true;
+    }
+
+    /// Ends the current phase, attributing the time since the last phase ended to it.
+    void endPhase(FramePhase phase) {
+        Uint64 now = SDL_GetPerformanceCounter();
+        current[phase] += toMs(now - mark);
+        TRACE_SPAN(framePhaseNames[phase], mark, now);
+        mark = now;
+    }
+
+    /// Ends the frame and adds its times to the statistics.
+    /// \param deltaTime The frame time the game was given, written to the CSV file.
+    /// \param allocations The frame's heap allocations, written to the CSV file.
+    void endFrame(double deltaTime, const AllocationCount &allocations = {0, 0}) {
+        if (!inFrame)
+            return;
+        inFrame = false;
+        double total = toMs(SDL_GetPerformanceCounter() - frameStart);
+        for (int phase = 0; phase < PHASE_COUNT; ++phase)
+            samples[phase][next] = current[phase];
+        samples[PHASE_COUNT][next] = total;
+        lastTotal = total;
+        next = (next + 1) % window;
+        frames++;
+
+        if (frames % summaryInterval == 0 || frames == 1)
+            summarise();
+
+        if (csv.is_open()) {
+            csv << frames << ',' << deltaTime;
+            for (double time : current)
+                csv << ',' << time;
+            csv << ',' << total;
+            if (allocationTracking)
+                csv << ',' << allocations.allocations << ',' << allocations.bytes;
+            csv << '\n';
+        }
+    }
+
+    /// The statistics of a phase as of the last summary.
+    /// \param phase The phase, or PHASE_COUNT for the whole frame.
+    const PhaseStats &summary(int phase) const {
+        return stats[phase];
+    }
+
+    int frameCount() const {
+        return frames;
+    }
+
+    /// The time of the last frame to end in ms.
+    double lastFrame() const {
+        return lastTotal;
+    }
+
+    void flush() {
+        if (csv.is_open())
+            csv.flush();
+    }
+
+private:
+    static double toMs(Uint64 ticks) {
+        return ticks * 1000 / (double)SDL_GetPerformanceFrequency();
+    }
+
+    void summarise() {
+        int count = std::min(frames, window);
+        for (int phase = 0; phase <= PHASE_COUNT; ++phase) {
+            std::copy(samples[phase].begin(), samples[phase].begin() + count, sorted.begin());
+            double sum = 0.0;
+            for (int i = 0; i < count; ++i)
+                sum += sorted[i];
+            int p99 = std::min(count - 1, count * 99 / 100);
+            std::nth_element(sorted.begin(), sorted.begin() + p99, sorted.begin() + count);
+            stats[phase] = {*std::min_element(sorted.begin(), sorted.begin() + count), sum / count, sorted[p99]};
+        }
+    }
+};
+
+/// The spread of the frame times of a stretch of play, such as a round, over up to a fixed number of frames.
+/// Its memory is allocated up front, so adding frames does not allocate. Once it is full, later frames replace earlier
+/// ones.
+class FrameTimeSpread {
+private:
+    std::vector<double> times;
+    size_t count = 0;
+
+public:
+    /// \param capacity The number of frames kept.
+    explicit FrameTimeSpread(size_t capacity) : times(capacity) {}
+
+    void reset() {
+        count = 0;
+    }
+
+    void add(double ms) {
+        if (times.empty())
+            return;
+        times[count % times.size()] = ms;
+        count++;
+    }
+
+    size_t frameCount() const {
+        return count;
+    }
+
+    /// The spread of the frames added since the last reset. This reorders the kept frames, so once the spread is
+    /// full it no longer replaces the earliest frames first.
+    PhaseStats summarise() {
+        size_t kept = std::min(count, times.size());
+        if (kept == 0)
+            return {0.0, 0.0, 0.0};
+        double sum = 0.0;
+        for (size_t i = 0; i < kept; ++i)
+            sum += times[i];
+        size_t p99 = std::min(kept - 1, kept * 99 / 100);
+        std::nth_element(times.begin(), times.begin() + p99, times.begin() + kept);
+        return {*std::min_element(times.begin(), times.begin() + kept), sum / kept, times[p99]};
+    }
+};
+
+/// Draws a FrameTimer's statistics straight to the window: the average frame split into phases as a stacked bar, then
+/// for each phase its colour, its average and 99th percentile in µs, and a bar of its average with a mark at the 99th
+/// percentile.
+class FrameTimeOverlay {
+private:
+    static constexpr int x = 8;
+    static constexpr int y = 8;
+    static constexpr int glyphScale = 2;
+    /// The width of a bar per ms.
+    static constexpr int pixelsPerMs = 20;
+    const std::array<SDL_Color, PHASE_COUNT + 1> colours = {{
+        {90, 160, 255, 255}, {255, 200, 60, 255}, {80, 200, 120, 255},
+        {40, 140, 70, 255}, {230, 90, 200, 255}, {240, 80, 70, 255}, {255, 255, 255, 255}
+    }};
+    std::array<NumberLabel, PHASE_COUNT + 1> averages;
+    std::array<NumberLabel, PHASE_COUNT + 1> percentiles;
+
+public:
+    FrameTimeOverlay() {
+        averages.fill(NumberLabel(5));
+        percentiles.fill(NumberLabel(5));
+    }
+
+    /// Draws the overlay on the current render target, which should be the window.
+    /// \param renderer The renderer to draw with.
+    /// \param timer The frame times to show.
+    /// \param font The font to draw numbers in.
+    void render(SDL_Renderer* renderer, const FrameTimer &timer, const BitmapFont &font) {
+        if (timer.frameCount() == 0)
+            return;
+        int glyphWidth = font.glyph(0)->w * glyphScale;
+        int glyphHeight = font.glyph(0)->h * glyphScale;
+        int rowHeight = std::max(glyphHeight, 12) + 4;
+        int numberWidth = (font.advance * glyphScale) * 5;
+        int barX = x + 16 + 2 * (numberWidth + glyphWidth);
+        int budgetWidth = static_cast<int>(1000.0 / 60.0 * pixelsPerMs);
+
+        SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+        SDL_Rect background = {x - 4, y - 4, barX - x + budgetWidth + 40, rowHeight * (PHASE_COUNT + 2) + 4};
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 160);
+        SDL_RenderFillRect(renderer, &background);
+
+        // The average frame, split into phases, against a 60 Hz frame budget
+        int stackX = x;
+        for (int phase = 0; phase < PHASE_COUNT; ++phase) {
+            int w = static_cast<int>(timer.summary(phase).avg * pixelsPerMs);
+            fillRect(renderer, {stackX, y, w, rowHeight - 4}, colours[phase]);
+            stackX += w;
+        }
+        fillRect(renderer, {x + budgetWidth, y - 2, 2, rowHeight}, colours[PHASE_COUNT]);
+
+        for (int row = 0; row <= PHASE_COUNT; ++row) {
+            const PhaseStats &stats = timer.summary(row);
+            int rowY = y + rowHeight * (row + 1);
+            fillRect(renderer, {x, rowY, 12, 12}, colours[row]);
+
+            averages[row].set(&font, static_cast<int>(stats.avg * 1000.0));
+            percentiles[row].set(&font, static_cast<int>(stats.p99 * 1000.0));
+            renderNumber(renderer, averages[row], x + 16, rowY);
+            renderNumber(renderer, percentiles[row], x + 16 + numberWidth + glyphWidth, rowY);
+
+            fillRect(renderer, {barX, rowY, static_cast<int>(stats.avg * pixelsPerMs), 12}, colours[row]);
+            fillRect(renderer, {barX + static_cast<int>(stats.p99 * pixelsPerMs), rowY - 2, 2, 16}, colours[PHASE_COUNT]);
+        }
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    }
+
+private:
+    static void fillRect(SDL_Renderer* renderer, SDL_Rect rect, SDL_Color colour) {
+        SDL_SetRenderDrawColor(renderer, colour.r, colour.g, colour.b, colour.a);
+        SDL_RenderFillRect(renderer, &rect);
+    }
+
+    static void renderNumber(SDL_Renderer* renderer, const NumberLabel &label, int x, int y) {
+        const BitmapFont* font = label.getFont();
+        for (int i = 0; i < label.size(); ++i) {
+            const SDL_Rect* glyph = label.glyph(i);
+            SDL_Rect dst = {x + i * font->advance * glyphScale, y, glyph->w * glyphScale, glyph->h * glyphScale};
+            SDL_RenderCopy(renderer, font->texture, glyph, &dst);
+        }
+    }
+};
+
+#endif //DUCKHUNT_FRAME_TIMER_HPP
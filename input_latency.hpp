@@ -0,0 +1,82 @@
+#ifndef DUCKHUNT_INPUT_LATENCY_HPP
+#define DUCKHUNT_INPUT_LATENCY_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include "SDL2/SDL.h"
+
+/// Measures the time from each click to the present of the first frame drawn after the click was handled, which is
+/// the first frame that can show the shot.
+/// The time a click waited in SDL's queue comes from its event timestamp, which SDL keeps in whole ms, and the time
+/// from handling it to the present from the performance counter. Session::pollEvent(SDL_Event* e) notes the clicks.
+class InputLatency {
+public:
+    /// The number of clicks the percentiles are taken over, the latest clicks replacing the oldest.
+    static constexpr size_t maxSamples = 65536;
+    /// The most clicks measured in one frame, the rest of a frame's clicks are not measured.
+    static constexpr size_t maxPending = 16;
+
+private:
+    struct PendingClick {
+        Uint64 handled;
+        double queued;
+    };
+
+    std::array<PendingClick, maxPending> pending{};
+    size_t pendingCount = 0;
+    /// Latencies in ms, reserved up front so measuring does not allocate during frames.
+    std::vector<double> samples;
+    size_t next = 0;
+    uint64_t clicks = 0;
+
+public:
+    InputLatency() {
+        samples.reserve(maxSamples);
+    }
+
+    /// Notes a click as it is handed to a scene.
+    /// \param queued How long the click waited in SDL's queue in ms.
+    void clickHandled(double queued) {
+        if (pendingCount == maxPending)
+            return;
+        pending[pendingCount++] = {SDL_GetPerformanceCounter(), queued};
+    }
+
+    /// Ends the wait of the clicks handled since the last present, call right after presenting a frame.
+    void presented() {
+        if (pendingCount == 0)
+            return;
+        Uint64 now = SDL_GetPerformanceCounter();
+        for (size_t i = 0; i < pendingCount; ++i) {
+            double latency = pending[i].queued + (now - pending[i].handled) * 1000 / (double)SDL_GetPerformanceFrequency();
+            if (samples.size() < maxSamples)
+                samples.push_back(latency);
+            else
+                samples[next] = latency;
+            next = (next + 1) % maxSamples;
+            clicks++;
+        }
+        pendingCount = 0;
+    }
+
+    /// Writes the spread of the latencies, in ms.
+    void report(std::ostream &os) const {
+        if (samples.empty()) {
+            os << "Click to present latency: no clicks" << std::endl;
+            return;
+        }
+        std::vector<double> sorted(samples);
+        std::sort(sorted.begin(), sorted.end());
+        auto percentile = [&sorted](int percent) {
+            return sorted[std::min(sorted.size() - 1, sorted.size() * percent / 100)];
+        };
+        os << "Click to present latency over " << sorted.size() << " of " << clicks << " clicks: min "
+           << sorted.front() << " ms, p50 " << percentile(50) << " ms, p90 " << percentile(90) << " ms, p99 "
+           << percentile(99) << " ms, max " << sorted.back() << " ms" << std::endl;
+    }
+};
+
+#endif //DUCKHUNT_INPUT_LATENCY_HPP
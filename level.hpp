@@ -2,21 +2,142 @@
 #define DUCKHUNT_LEVEL_HPP
 
 #include "scene.hpp"
+#include "duck_swarm.hpp"
+#include "spatial_grid.hpp"
+
+/// What a step of a flight of ducks, Level::stepFlight(double deltaTime, int* landedX, DuckColours* landedColour),
+/// leaves for the game to show.
+enum FlightStep {
+    FLIGHT_CONTINUES,
+    /// The flight's time ran out with ducks still alive, which fly away.
+    FLIGHT_TIMED_OUT,
+    /// The last duck of the flight landed, ending it.
+    FLIGHT_LANDED
+};
 
 class Level : public Scene {
+public:
+    /// The most ducks the endless game releases at once.
+    static constexpr int maxEndlessDucks = 512;
+    /// How long each release of ducks in the endless game lasts in ms.
+    static constexpr double endlessFlightTime = 10000.0;
+
 protected:
     std::vector<Duck> ducks;
     DuckHatchery hatchery;
     DuckColours firstDuckColour;
+    /// How long the ducks of the endless game stay before flying away, however many shots are left.
+    Timer flightTimer;
+    /// The ducks by the area they were shown in and are in now, rebuilt whenever they move or are released.
+    SpatialGrid grid;
 
 public:
-    Level(Drawer *drawer, Player_Stats *player_stats, Textures *textures)
-        : Scene(drawer, player_stats, textures), hatchery(textures, drawer) {
-        ducks = {};
+    Level(Session *session, Drawer *drawer, Player_Stats *player_stats, Textures *textures)
+        : Scene(session, drawer, player_stats, textures), hatchery(hatch(textures, drawer, &session->random)),
+          flightTimer(endlessFlightTime), grid(gridArea(drawer), 64) {
+        // Room for every duck on screen at once, so spawning and shooting do not allocate
+        ducks.reserve(player_stats->ducks_simultaneous);
+        grid.reserve(player_stats->ducks_simultaneous);
         firstDuckColour = NO_COLOUR;
+        if (!player_stats->endless)
+            flightTimer.disable();
         trySpawnDuck();
     }
 
+    /// Builds the duck hatchery, timed as a trace zone.
+    static DuckHatchery hatch(Textures* textures, Drawer* drawer, std::mt19937* mt) {
+        TRACE_ZONE("DuckHatchery");
+        return DuckHatchery(textures, drawer, mt);
+    }
+
+    /// The area ducks fly in, from the bottom of the bushes up and across the screen.
+    static SDL_Rect gridArea(Drawer* drawer) {
+        auto left = static_cast<int>(drawer->worldLeft());
+        return {left, 0, static_cast<int>(drawer->worldRight()) - left, 200};
+    }
+
+    /// Lists the ducks in the grid by Duck::shownSpan(), call after they move or are released.
+    void rebuildGrid() {
+        grid.rebuild(ducks.size(), [this](size_t i, SDL_Rect* bounds) {
+            *bounds = ducks[i].shownSpan();
+            return ducks[i].alive;
+        });
+    }
+
+    /// Finds the living duck drawn on top at a point, testing against the pixels of its current frame.
+    /// Only the ducks the grid finds near the point are tested.
+    /// \return The duck, or nullptr if the point misses every living duck.
+    Duck* duckAt(int worldX, int worldY) {
+        int hit = -1;
+        grid.forEachNear(worldX, worldY, [&](int i) {
+            if (i > hit && ducks[i].alive && ducks[i].hits(worldX, worldY))
+                hit = i;
+        });
+        return hit >= 0 ? &ducks[hit] : nullptr;
+    }
+
+    /// Finds the living duck that was drawn on top at a point at a time, so a shot hits what was on screen when the
+    /// player clicked, however far the ducks have moved since.
+    /// \param time The game time of the shot in ms, e.g. its event's timestamp.
+    /// \return The duck, or nullptr if the point missed every living duck.
+    Duck* duckShownAt(int worldX, int worldY, double time) {
+        int hit = -1;
+        grid.forEachNear(worldX, worldY, [&](int i) {
+            if (i > hit && ducks[i].alive && ducks[i].hitsShown(time, worldX, worldY))
+                hit = i;
+        });
+        return hit >= 0 ? &ducks[hit] : nullptr;
+    }
+
+    /// Plays a step of the current flight without drawing it: moves the ducks, ends the flight once its time is up and
+    /// removes the ducks that landed. The game and the balance simulator both play by it.
+    /// \param deltaTime The time to move on in ms.
+    /// \param landedX Set to where the last duck of the flight landed, when it did.
+    /// \param landedColour Set to the colour of the last duck of the flight, when it landed.
+    /// \return What the game should show.
+    FlightStep stepFlight(double deltaTime, int* landedX, DuckColours* landedColour) {
+        FlightStep step = moveFlight(deltaTime, landedX, landedColour);
+        rebuildGrid();
+        return step;
+    }
+
+    /// Fires one of the flight's shots, killing the living duck that was on screen at the point.
+    /// \param time The game time of the shot in ms.
+    /// \return The duck shot, or nullptr if the shot missed.
+    Duck* shoot(int worldX, int worldY, double time) {
+        player_stats->shots_left -= 1;
+        Duck* duck = duckShownAt(worldX, worldY, time);
+        if (duck != nullptr)
+            killDuck(duck);
+        return duck;
+    }
+
+    /// Whether the flight's shots have run out with ducks still alive, which then fly away.
+    bool outOfShots() {
+        return player_stats->shots_left == 0 && livingDucks() > 0;
+    }
+
+    /// Releases the next ducks with a full set of shots, if there are ducks left in the round.
+    void launchDucks() {
+        if (trySpawnDuck()) {
+            player_stats->shots_left = player_stats->shots_per_flight;
+            firstDuckColour = NO_COLOUR;
+            flightTimer.reset(endlessFlightTime);
+        }
+    }
+
+    /// Aims at the first living duck as it is on screen, as a player would.
+    bool autoTarget(int* x, int* y) override {
+        for (auto &duck : ducks)
+            if (duck.alive) {
+                SDL_Rect bounds = duck.shownBounds(session->gameTime());
+                *x = bounds.x + bounds.w / 2;
+                *y = bounds.y + bounds.h / 2;
+                return true;
+            }
+        return false;
+    }
+
     int livingDucks() {
         int count = 0;
         for (auto &duck : ducks)
@@ -25,21 +146,22 @@ public:
         return count;
     }
 
-    /// Spawns a duck
+    /// Releases the next ducks, filling the next slots of the round.
     void spawnDuck() {
-        std::random_device rd;
-        auto mt = std::mt19937(rd());
         std::uniform_int_distribution<int> dist(0, 10);
         for (int i = 0; i < player_stats->ducks_simultaneous; ++i) {
             DuckColours colour = BROWN;
-            int duckColourRandom = dist(mt);
+            int duckColourRandom = dist(session->random);
             if (duckColourRandom < 1)
                 colour = RED;
             else if (duckColourRandom < 5)
                 colour = BLUE;
-            ducks.push_back(hatchery.newDuck(colour, scoreForDuck(player_stats->round, colour), player_stats->round, player_stats->duck_next));
-            player_stats->ducks_current.push_back(player_stats->duck_next++);
+            int slot = player_stats->duck_next + i / player_stats->ducks_per_slot;
+            ducks.push_back(hatchery.newDuck(colour, scoreForDuck(player_stats->round, colour), player_stats->round, slot));
+            player_stats->ducks_current |= 1u << slot;
         }
+        player_stats->duck_next += player_stats->ducks_simultaneous / player_stats->ducks_per_slot;
+        rebuildGrid();
     }
 
     /// Spawns a duck if there are still ducks left in the round and no ducks on screen.
@@ -56,8 +178,14 @@ public:
         player_stats->round++;
         player_stats->duck_next = 0;
         player_stats->ducks_needed = ducksNeededForRound(player_stats->round);
-        for (bool &duck_hit : player_stats->ducks_hit)
-            duck_hit = false;
+        player_stats->ducks_hit = {};
+        player_stats->slot_hits = {};
+        if (player_stats->endless) {
+            player_stats->ducks_needed = 0;
+            setEndlessDucks(player_stats, player_stats->round);
+            ducks.reserve(player_stats->ducks_simultaneous);
+            grid.reserve(player_stats->ducks_simultaneous);
+        }
     }
 
     bool areDucksFinished() {
@@ -75,9 +203,14 @@ public:
 
     void killDuck (Duck* duck) {
         player_stats->score += duck->kill();
-        // Remove duck from vector
-        player_stats->ducks_current.erase(std::remove(player_stats->ducks_current.begin(), player_stats->ducks_current.end(), duck->index), player_stats->ducks_current.end());
-        player_stats->ducks_hit[duck->index] = true;
+        int slot = duck->index;
+        if (++player_stats->slot_hits[slot] * 2 >= player_stats->ducks_per_slot)
+            player_stats->ducks_hit[slot] = true;
+        bool slotOnScreen = false;
+        for (auto &other : ducks)
+            slotOnScreen = slotOnScreen || (other.alive && other.index == slot);
+        if (!slotOnScreen)
+            player_stats->ducks_current &= ~(1u << slot);
     }
 
     static int scoreForDuck(int round, DuckColours colour) {
@@ -110,12 +243,14 @@ public:
     static Player_Stats singleDuckGame() {
         return {
             .ducks_hit = {},
-            .ducks_current={},
+            .ducks_current = 0,
             .ducks_needed = ducksNeededForRound(1),
-            .duck_next = 0, .ducks_simultaneous = 1,
+            .duck_next = 0, .ducks_simultaneous = 1, .ducks_per_slot = 1,
+            .slot_hits = {},
             .round = 1,
             .score = 0,
-            .shots_left = 3
+            .shots_left = 3, .shots_per_flight = 3,
+            .endless = false, .last_round = 0
         };
     }
 
@@ -124,77 +259,125 @@ public:
         stats.ducks_simultaneous = 2;
         return stats;
     }
-};
 
-class SinglePlayerGame : public Level {
-public:
-    SinglePlayerGame(Drawer *drawer, Player_Stats *player_stats, Textures *textures)
-    : Level(drawer, player_stats, textures) {
+    /// A game that releases one slot's ducks at a time, doubling them every round up to ::maxEndlessDucks, to see how
+    /// many ducks the machine can keep up with.
+    /// \param lastRound The last round to play, 0 to play until the player leaves.
+    static Player_Stats endlessGame(int lastRound) {
+        Player_Stats stats = singleDuckGame();
+        stats.ducks_needed = 0;
+        stats.endless = true;
+        stats.last_round = lastRound;
+        setEndlessDucks(&stats, 1);
+        stats.shots_left = stats.shots_per_flight;
+        return stats;
     }
 
-    bool update(double deltaTime) override {
-        for (auto &duck : ducks)
+    static void setEndlessDucks(Player_Stats* stats, int round) {
+        stats->ducks_simultaneous = std::min(maxEndlessDucks, 1 << std::min(round - 1, 16));
+        stats->ducks_per_slot = stats->ducks_simultaneous;
+        stats->shots_per_flight = stats->ducks_simultaneous + 2;
+    }
+
+private:
+    /// The moves of ::stepFlight(double deltaTime, int* landedX, DuckColours* landedColour), before the grid is rebuilt.
+    FlightStep moveFlight(double deltaTime, int* landedX, DuckColours* landedColour) {
+        for (auto &duck : ducks) {
+            duck.storePosition();
             duck.update(deltaTime);
+        }
+
+        if (flightTimer.tick(deltaTime) && livingDucks() > 0)
+            return FLIGHT_TIMED_OUT;
 
         auto iter = begin(ducks);
         while (iter != ducks.end()) {
-            iter->update(deltaTime);
             if (iter->y > hatchery.spawnY) {
-                if (ducks.size() == 2)
-                    firstDuckColour = iter->colour;
-                // Show success cut scene
-                else if (ducks.size() == 1) {
-                    auto x = static_cast<int>(iter->x);
-                    SuccessCutScene* successCutScene;
-                    if (player_stats->ducks_simultaneous == 2)
-                        successCutScene = new SuccessCutScene(this, x, firstDuckColour, iter->colour);
-                    else
-                        successCutScene = new SuccessCutScene(this, x, iter->colour);
-                    successCutScene->start();
-                    delete successCutScene;
-                    now = SDL_GetPerformanceCounter(); // TODO: Not very accurate
+                // The dog holds up the first and the last duck to land
+                if (ducks.size() > 1) {
+                    if (firstDuckColour == NO_COLOUR)
+                        firstDuckColour = iter->colour;
+                }
+                else {
+                    *landedX = static_cast<int>(iter->x);
+                    *landedColour = iter->colour;
+                    ducks.erase(iter);
+                    return FLIGHT_LANDED;
                 }
                 iter = ducks.erase(iter);
-
-                if (trySpawnDuckOrStartNewRound())
-                    return true;
             }
             else
                 iter++;
         }
+        return FLIGHT_CONTINUES;
+    }
+};
+
+enum SinglePlayerGameState {
+    PLAYING,
+    SHOWING_SUCCESS,
+    FLYING_AWAY,
+    SHOWING_FAILURE,
+    COALESCING,
+    FLASHING,
+    SHOWING_GAME_OVER
+};
+
+class SinglePlayerGame : public Level {
+private:
+    /// The scene shown on top of the game, if any.
+    SinglePlayerGameState gameState;
+    /// The times of the frames played in the current round of the endless game, leaving out the scenes between ducks.
+    FrameTimeSpread roundFrames;
+
+public:
+    /// The number of frames of a round the endless game reports on, a little over a round of ten releases at 60 Hz.
+    static constexpr size_t roundFrameCapacity = 8192;
+
+    SinglePlayerGame(Session *session, Drawer *drawer, Player_Stats *player_stats, Textures *textures)
+    : Level(session, drawer, player_stats, textures), roundFrames(player_stats->endless ? roundFrameCapacity : 0) {
+        gameState = PLAYING;
+    }
+
+    const char* name() override {
+        return "SinglePlayerGame";
+    }
+
+    bool update(double deltaTime) override {
+        int landedX;
+        DuckColours landedColour;
+        switch (stepFlight(deltaTime, &landedX, &landedColour)) {
+            case FLIGHT_TIMED_OUT:
+                flyAway();
+                break;
+            // Show success cut scene
+            case FLIGHT_LANDED:
+                if (firstDuckColour != NO_COLOUR)
+                    show(std::make_unique<SuccessCutScene>(this, landedX, firstDuckColour, landedColour));
+                else
+                    show(std::make_unique<SuccessCutScene>(this, landedX, landedColour));
+                gameState = SHOWING_SUCCESS;
+                break;
+            default:
+                break;
+        }
+        return false;
     }
 
     bool handleInput(SDL_Event e) override {
         Scene::handleInput(e);
+        // The endless game is left from the keyboard, as it cannot be lost
+        if (player_stats->endless && e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_ESCAPE)
+            return true;
         if (e.type == SDL_MOUSEBUTTONDOWN) {
             if (player_stats->shots_left > 0) {
-                player_stats->shots_left -= 1;
-
-                // See if duck was hit
-                int mX, mY;
-                SDL_GetMouseState(&mX, &mY);
-                for (auto &duck : ducks) {
-                    int wX = mX, wY = mY;
-                    drawer->screenPointToWorldPoint(&wX, &wY);
-                    if (duck.alive && wX > duck.x && wX < duck.x + duck.width() && wY > duck.y && wY < duck.y + duck.height()) {
-                        killDuck(&duck);
-                        break;
-                    }
-                }
+                // See if a duck was hit, where it was on screen when the player clicked
+                int wX = e.button.x, wY = e.button.y;
+                drawer->screenPointToWorldPoint(&wX, &wY);
+                shoot(wX, wY, e.button.timestamp);
                 // Handle no shots left
-                if (player_stats->shots_left == 0 && livingDucks() > 0) {
-                    player_stats->ducks_current = {};
-                    Duck* duck2 = nullptr;
-                    if (ducks.size() == 2)
-                        duck2 = &ducks.at(1);
-                    FlyAwayDuck(this, &ducks.at(0), duck2).start();
-                    ducks = {};
-                    FailureCutScene(this).start();
-                    now = SDL_GetPerformanceCounter(); // TODO: Not very accurate
-
-                    if (trySpawnDuckOrStartNewRound())
-                        return true;
-                }
+                if (outOfShots())
+                    flyAway();
             }
         }
         return false;
@@ -203,8 +386,10 @@ public:
     bool renderBackground(double deltaTime) override {
         Scene::renderBackground(deltaTime);
 
-        for (auto &duck : ducks)
-            duck.render(drawer, deltaTime);
+        for (auto &duck : ducks) {
+            duck.render(drawer, deltaTime, interpolation);
+            duck.rememberShown(session->gameTime(), interpolation);
+        }
 
         return false;
     }
@@ -219,25 +404,145 @@ public:
         return false;
     }
 
+    void frameTimed(double ms) override {
+        if (gameState == PLAYING)
+            roundFrames.add(ms);
+    }
+
+    bool resume() override {
+        switch (gameState) {
+            case SHOWING_SUCCESS:
+            case SHOWING_FAILURE:
+                gameState = PLAYING;
+                return trySpawnDuckOrStartNewRound();
+            case FLYING_AWAY:
+                ducks.clear();
+                rebuildGrid();
+                show(std::make_unique<FailureCutScene>(this));
+                gameState = SHOWING_FAILURE;
+                return false;
+            case COALESCING:
+                if (ducksHit() >= player_stats->ducks_needed) {
+                    show(std::make_unique<DuckUIFlash>(this));
+                    gameState = FLASHING;
+                }
+                else {
+                    show(std::make_unique<GameOver>(this));
+                    gameState = SHOWING_GAME_OVER;
+                }
+                return false;
+            case FLASHING:
+                reportRound();
+                if (player_stats->last_round > 0 && player_stats->round >= player_stats->last_round)
+                    return true;
+                gameState = PLAYING;
+                roundFrames.reset();
+                startNewRound();
+                launchDucks();
+                return false;
+            case SHOWING_GAME_OVER:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    /// Launches the next ducks, or shows the end of the round once all of its ducks are done.
+    /// \return true if the game is over, false otherwise.
     bool trySpawnDuckOrStartNewRound() {
         // Start new round
         if (areDucksFinished()) {
-            DuckUICoalesce(this).start();
-            now = SDL_GetPerformanceCounter(); // TODO: Not very accurate
-            if (ducksHit() >= player_stats->ducks_needed) {
-                DuckUIFlash(this).start();
-                now = SDL_GetPerformanceCounter(); // TODO: Not very accurate
-                startNewRound();
-            }
-            else {
-                GameOver(this).start();
-                return true;
+            show(std::make_unique<DuckUICoalesce>(this));
+            gameState = COALESCING;
+            return false;
+        }
+        launchDucks();
+        return false;
+    }
+
+private:
+    /// Sends the living ducks away, when the shots or the time for them ran out.
+    void flyAway() {
+        player_stats->ducks_current = 0;
+        show(std::make_unique<FlyAwayDuck>(this, &ducks));
+        gameState = FLYING_AWAY;
+    }
+
+    /// Prints how the frame time held up with the round's ducks in the endless game, over the frames the ducks were
+    /// in play.
+    void reportRound() {
+        if (!player_stats->endless)
+            return;
+        PhaseStats frame = roundFrames.summarise();
+        std::cout << "Round " << player_stats->round << ": " << player_stats->ducks_simultaneous
+                  << " ducks at once over " << roundFrames.frameCount() << " frames, frame avg " << frame.avg
+                  << " ms, p99 " << frame.p99 << " ms" << std::endl;
+    }
+};
+
+/// An attraction mode filling the sky with a swarm of ducks, which keep flying until they are shot.
+class SwarmMode : public Scene {
+private:
+    DuckSwarm swarm;
+    /// Ends the swarm after a time, disabled when it runs until the user leaves.
+    Timer duration;
+    int shot;
+
+public:
+    /// \param ducks The number of ducks in the swarm.
+    /// \param duration How long to run for in ms, 0 to run until the user presses escape or shoots every duck.
+    SwarmMode(Session *session, Drawer *drawer, Player_Stats *player_stats, Textures *textures, int ducks, double duration)
+        : Scene(session, drawer, player_stats, textures), swarm(textures, drawer, &session->random), duration(duration) {
+        if (duration <= 0.0)
+            this->duration.disable();
+        shot = 0;
+        swarm.spawn(static_cast<size_t>(ducks));
+    }
+
+    const char* name() override {
+        return "SwarmMode";
+    }
+
+    int ducksShot() {
+        return shot;
+    }
+
+    int ducksLeft() {
+        return static_cast<int>(swarm.size());
+    }
+
+    bool update(double deltaTime) override {
+        swarm.update(deltaTime);
+        return duration.tick(deltaTime) || swarm.size() == 0;
+    }
+
+    bool handleInput(SDL_Event e) override {
+        Scene::handleInput(e);
+        if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_ESCAPE)
+            return true;
+        if (e.type == SDL_MOUSEBUTTONDOWN) {
+            int wX = e.button.x, wY = e.button.y;
+            drawer->screenPointToWorldPoint(&wX, &wY);
+            long duck = swarm.hitTest(wX, wY);
+            if (duck >= 0) {
+                swarm.remove(static_cast<size_t>(duck));
+                player_stats->score += Level::scoreForDuck(player_stats->round, BROWN);
+                shot++;
             }
         }
-        // Launch new ducks
-        if (trySpawnDuck())
-            player_stats->shots_left = 3;
+        return swarm.size() == 0;
+    }
+
+    bool autoTarget(int* x, int* y) override {
+        if (swarm.size() == 0)
+            return false;
+        swarm.centre(swarm.size() - 1, x, y);
+        return true;
+    }
 
+    bool renderBackground(double deltaTime) override {
+        Scene::renderBackground(deltaTime);
+        swarm.render(drawer, interpolation);
         return false;
     }
 };
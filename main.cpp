@@ -3,32 +3,75 @@
 #include "dog.hpp"
 #include "level.hpp"
 #include "config.hpp"
+#include "session.hpp"
 
 //const int SCREEN_WIDTH  = 960;
 //const int SCREEN_HEIGHT = 540;
 const int SCREEN_WIDTH  = 256 * 3;
 const int SCREEN_HEIGHT = 224 * 3;
 const std::string CONFIG_PATH = "./config.cfg";
+/// How long a headless swarm runs for in ms.
+const double swarmHeadlessDuration = 30000.0;
+/// The number of rounds of the endless game played headless, the last of them with Level::maxEndlessDucks.
+const int endlessHeadlessRounds = 10;
+
+/// Checks that the steady frames of the scene given with --check-allocations did not allocate.
+/// \return false if they did, or if allocations are not tracked by this build.
+bool checkAllocations(Session &session) {
+    if (session.allocationCheckScene.empty())
+        return true;
+    if (!allocationTracking) {
+        std::cout << "Checking allocations needs a build with DUCKHUNT_TRACK_ALLOCATIONS" << std::endl;
+        return false;
+    }
+    uint64_t frames = session.allocationStats.steadyFramesAllocating(session.allocationCheckScene.c_str());
+    if (frames > 0) {
+        std::cout << frames << " steady frames of " << session.allocationCheckScene << " allocated" << std::endl;
+        return false;
+    }
+    return true;
+}
 
 int main(int argc, char* argv []) {
-    // Start SDL
-    if (SDL_Init(SDL_INIT_EVERYTHING) != 0) {
+    Session session;
+    if (!session.parseArguments(argc, argv) || !session.open())
+        return 1;
+
+    // Start SDL, headless runs only need its clock
+    if (SDL_Init(session.headless ? SDL_INIT_TIMER : SDL_INIT_EVERYTHING) != 0) {
         logSDLError(std::cout, "SDL_Init");
         return 1;
     }
 
-    SDL_Window *window = SDL_CreateWindow("Super Duck Hunt", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
-    if (window == nullptr) {
-        logSDLError(std::cout, "CreateWindow");
-        SDL_Quit();
-        return 1;
+    SDL_Window *window = nullptr;
+    SDL_Renderer *renderer = nullptr;
+    SDL_Surface *offscreen = nullptr;
+    if (session.soakDuration > 0.0 || (session.headless && !session.allocationCheckScene.empty())) {
+        // Soak tests and headless allocation checks draw every frame to a surface with the software renderer, so
+        // rendering is tested without a display
+        offscreen = SDL_CreateRGBSurfaceWithFormat(0, SCREEN_WIDTH, SCREEN_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+        renderer = offscreen != nullptr ? SDL_CreateSoftwareRenderer(offscreen) : nullptr;
+        if (renderer == nullptr) {
+            logSDLError(std::cout, "CreateSoftwareRenderer");
+            SDL_FreeSurface(offscreen);
+            SDL_Quit();
+            return 1;
+        }
     }
-    SDL_Renderer *renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
-    if (renderer == nullptr) {
-        logSDLError(std::cout, "CreateRenderer");
-        cleanup(window);
-        SDL_Quit();
-        return 1;
+    else if (!session.headless) {
+        window = SDL_CreateWindow("Super Duck Hunt", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
+        if (window == nullptr) {
+            logSDLError(std::cout, "CreateWindow");
+            SDL_Quit();
+            return 1;
+        }
+        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+        if (renderer == nullptr) {
+            logSDLError(std::cout, "CreateRenderer");
+            cleanup(window);
+            SDL_Quit();
+            return 1;
+        }
     }
 
     Config config{};
@@ -38,31 +81,76 @@ int main(int argc, char* argv []) {
         textures = loadTexturesRemake(renderer);
     else
         textures = loadTexturesOriginal(renderer);
-    if (!validateTextures(&textures)) {
+    if (!validateTextures(&textures, renderer != nullptr)) {
         cleanup(&textures, renderer, window);
+        SDL_FreeSurface(offscreen);
         SDL_Quit();
         return 1;
     }
 
-    while (true) {
+    TextureSets textureSets(&textures, config.useRemakeTextures);
+    session.textureSets = &textureSets;
+    TextureWatcher textureWatcher(&textures, &textureSets);
+    if (session.watchTextures && textureWatcher.start())
+        session.textureWatcher = &textureWatcher;
+
+    // The shooter has its own generator, so replays without it draw the same numbers from the session's
+    AutoShooter shooter(session.reactionTime, session.accuracy, session.seed + 1);
+    if (session.headless && !session.isReplaying())
+        session.shooter = &shooter;
+
+    // Replayed clicks are stamped with the times of the recorded run, so their latency cannot be measured
+    InputLatency inputLatency;
+    if (session.measureInputLatency && !session.isReplaying())
+        session.inputLatency = &inputLatency;
+    else if (session.measureInputLatency)
+        std::cout << "Input latency is not measured in replays" << std::endl;
+
+    SoakMonitor soak(session.soakDuration, session.soakInterval, session.soakThreshold);
+    if (session.soakDuration > 0.0)
+        session.soak = &soak;
+
+    while (!session.isFinished()) {
         try {
             config.load(CONFIG_PATH);
-            Drawer drawer(textures.background, renderer, SCREEN_WIDTH, SCREEN_HEIGHT);
+            textureSets.request(config.useRemakeTextures);
+            Drawer drawer(textures.background, renderer, SCREEN_WIDTH, SCREEN_HEIGHT, config.nativeResolution, config.integerScaling);
+
+            if (session.swarmSize > 0) {
+                // Headless swarms run for a fixed time, as the shooter would take too long to clear them
+                Player_Stats player_stats = Level::singleDuckGame();
+                SwarmMode swarm(&session, &drawer, &player_stats, &textures, session.swarmSize,
+                                session.headless ? swarmHeadlessDuration : 0.0);
+                swarm.start();
+                std::cout << "Swarm: " << swarm.ducksShot() << " ducks shot, " << swarm.ducksLeft()
+                          << " left, score " << player_stats.score << std::endl;
+                break;
+            }
 
-            MainMenu mainMenu(&drawer, &textures, config.highScore);
+            MainMenu mainMenu(&session, &drawer, &textures, config.highScore);
             mainMenu.start();
 
             Player_Stats player_stats;
-            if (mainMenu.resultGameType() == SINGLE)
+            GameType gameType = session.endless ? ENDLESS : mainMenu.resultGameType();
+            if (gameType == SINGLE)
                 player_stats = Level::singleDuckGame();
-            else if (mainMenu.resultGameType() == DOUBLE)
+            else if (gameType == DOUBLE)
                 player_stats = Level::doubleDuckGame();
+            else
+                player_stats = Level::endlessGame(session.headless ? endlessHeadlessRounds : 0);
 
-            IntroCutScene(&drawer, &player_stats, &textures).start();
+            IntroCutScene(&session, &drawer, &player_stats, &textures).start();
 
-            SinglePlayerGame(&drawer, &player_stats, &textures).start();
+            SinglePlayerGame(&session, &drawer, &player_stats, &textures).start();
+            session.gamesPlayed++;
+            if (session.headless || session.isReplaying()) {
+                std::cout << "Game " << session.gamesPlayed << ": round " << player_stats.round
+                          << ", score " << player_stats.score << std::endl;
+                continue;
+            }
             if (player_stats.score > config.highScore)
                 config.highScore = player_stats.score;
+            config.useRemakeTextures = textureSets.willBeRemake();
 
             config.save(CONFIG_PATH);
         }
@@ -72,6 +160,16 @@ int main(int argc, char* argv []) {
     }
 
     std::cout << "Quiting game." << std::endl;
+    TRACE_DUMP(traceFile);
+    if (allocationTracking)
+        session.allocationStats.report(std::cout);
+    if (session.inputLatency != nullptr)
+        inputLatency.report(std::cout);
+    bool passed = checkAllocations(session);
+    if (session.soak != nullptr)
+        passed = soak.judge(std::cout) && passed;
     cleanup(&textures, renderer, window);
+    SDL_FreeSurface(offscreen);
     SDL_Quit();
+    return passed ? 0 : 1;
 }
@@ -8,15 +8,15 @@ class Message {
 protected:
     int x;
     int y;
-    SDL_Texture* texture;
+    const TextureRegion* texture;
     Timer timer;
     bool shouldRender;
 
 public:
-    Message(int x, int y, double duration, SDL_Texture* texture) : timer(duration) {
+    Message(int x, int y, double duration, const TextureRegion &texture) : timer(duration) {
         this->x = x;
         this->y = y;
-        this->texture = texture;
+        this->texture = &texture;
         shouldRender = true;
     }
 
@@ -26,7 +26,7 @@ public:
     /// \return true if the message time is expired, false otherwise
     virtual void render(Drawer* drawer, double deltaTime) {
         if (shouldRender) {
-            drawer->renderTexture(texture, x, y);
+            drawer->renderTexture(*texture, x, y);
             if (timer.tick(deltaTime))
                 shouldRender = false;
         }
@@ -35,43 +35,36 @@ public:
 
 class PerfectMessage : public Message {
 private:
-    std::string score;
-    SDL_Texture* numbersTex;
+    NumberLabel score;
 public:
-    PerfectMessage(int x, int y, double duration, SDL_Texture* texture, int score, SDL_Texture* numbersTex)
+    PerfectMessage(int x, int y, double duration, const TextureRegion &texture, int score, const BitmapFont* numbersFont)
         : Message(x, y, duration, texture) {
-        this->score = std::to_string(score);
-        std::reverse(this->score.begin(), this->score.end());
-        this->numbersTex = numbersTex;
+        this->score.set(numbersFont, score);
     }
 
     void render(Drawer* drawer, double deltaTime) override {
         Message::render(drawer, deltaTime);
 
         if (shouldRender)
-            for (int i = 0; i < score.size(); ++i)
-                drawer->renderCharacter(numbersTex, score[i], x + i * 8, y + 20);
+            drawer->renderNumber(score, x, y + 20);
     }
 };
 
 class RoundMessage : public Message {
 private:
-    std::string round;
-    SDL_Texture* numbersTex;
+    NumberLabel round;
 public:
-    RoundMessage(int x, int y, double duration, SDL_Texture* texture, int round, SDL_Texture* numbersTex)
+    RoundMessage(int x, int y, double duration, const TextureRegion &texture, int round, const BitmapFont* numbersFont)
         : Message(x, y, duration, texture) {
-        this->round = std::to_string(round);
-        this->numbersTex = numbersTex;
+        this->round.set(numbersFont, round);
     }
 
     void render(Drawer* drawer, double deltaTime) override {
         Message::render(drawer, deltaTime);
 
-        int x_offset = 21 - 4 * static_cast<int>(round.size() - 1);
+        int x_offset = 21 - 4 * (round.size() - 1);
         if (shouldRender)
-            for (int i = 0; i < round.size(); ++i)
-                drawer->renderCharacter(numbersTex, round[i], x + x_offset + i * 8, y + 21);
+            drawer->renderNumber(round, x + x_offset, y + 21);
     }
 };
 
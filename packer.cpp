@@ -0,0 +1,88 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "textures.hpp"
+#include "texture_pack.hpp"
+
+// Decodes the PNGs of both texture sets and writes them to a texture pack, which the game loads in place of the PNGs.
+// Run from the directory holding textures/, e.g.
+//   duckhunt_packer [output file]
+
+struct PackedTexture {
+    PackEntry entry;
+    SDL_Surface* surface;
+};
+
+int main(int argc, char* argv []) {
+    std::string outPath = argc > 1 ? argv[1] : texturePackFile;
+
+    // Both sets share some files, which are only packed once
+    std::vector<PackedTexture> textures;
+    bool failed = false;
+    for (auto &file : textureFiles) {
+        for (const char* source : {file.remake, file.original}) {
+            bool packed = false;
+            for (auto &texture : textures)
+                packed = packed || std::strcmp(texture.entry.source, source) == 0;
+            if (packed)
+                continue;
+
+            PackEntry entry{};
+            if (std::strlen(source) >= sizeof(entry.source)) {
+                std::cout << "Path too long for a texture pack: " << source << std::endl;
+                failed = true;
+                continue;
+            }
+            SDL_Surface* surface = loadSurface(source);
+            if (surface == nullptr || !sourceStamp(source, &entry.sourceSize, &entry.sourceModified)) {
+                failed = true;
+                SDL_FreeSurface(surface);
+                continue;
+            }
+            std::strcpy(entry.source, source);
+            entry.width = static_cast<uint32_t>(surface->w);
+            entry.height = static_cast<uint32_t>(surface->h);
+            entry.pitch = entry.width * 4;
+            entry.frames = static_cast<uint32_t>(file.frames);
+            textures.push_back({entry, surface});
+        }
+    }
+
+    if (!failed) {
+        // Lay the pixels out after the index
+        uint64_t offset = sizeof(PackHeader) + textures.size() * sizeof(PackEntry);
+        for (auto &texture : textures) {
+            offset = (offset + texturePackAlignment - 1) / texturePackAlignment * texturePackAlignment;
+            texture.entry.offset = offset;
+            offset += uint64_t(texture.entry.pitch) * texture.entry.height;
+        }
+
+        std::ofstream out(outPath, std::ios::binary | std::ios::trunc);
+        PackHeader header{};
+        std::memcpy(header.magic, texturePackMagic, sizeof(header.magic));
+        header.version = texturePackVersion;
+        header.entryCount = static_cast<uint32_t>(textures.size());
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (auto &texture : textures)
+            out.write(reinterpret_cast<const char*>(&texture.entry), sizeof(PackEntry));
+        for (auto &texture : textures) {
+            while (static_cast<uint64_t>(out.tellp()) < texture.entry.offset)
+                out.put('\0');
+            SDL_LockSurface(texture.surface);
+            for (int y = 0; y < texture.surface->h; ++y)
+                out.write(static_cast<const char*>(texture.surface->pixels) + y * texture.surface->pitch, texture.entry.pitch);
+            SDL_UnlockSurface(texture.surface);
+        }
+        failed = !out.good();
+        if (failed)
+            std::cout << "Could not write " << outPath << std::endl;
+        else
+            std::cout << "Packed " << textures.size() << " textures into " << outPath << std::endl;
+    }
+
+    for (auto &texture : textures)
+        SDL_FreeSurface(texture.surface);
+    IMG_Quit();
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,37 @@
+#ifndef DUCKHUNT_PARALLEL_HPP
+#define DUCKHUNT_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/// The number of threads to use for parallel work, at least 1.
+inline unsigned int workerCount() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/// Runs task(i) for every i from 0 to count - 1, spread over a pool of threads that take the next index as they finish
+/// one. The calling thread is one of the pool, and the call returns once every task has finished.
+/// \param count The number of tasks.
+/// \param task The work to do for an index, called from several threads at once.
+/// \param threads The most threads to use, including the calling thread.
+template<typename Task>
+void parallelFor(size_t count, Task task, unsigned int threads = workerCount()) {
+    std::atomic<size_t> next(0);
+    auto work = [&]() {
+        for (size_t i = next++; i < count; i = next++)
+            task(i);
+    };
+
+    std::vector<std::thread> workers;
+    size_t extraThreads = std::min<size_t>(count, std::max(1u, threads)) - std::min<size_t>(count, 1);
+    workers.reserve(extraThreads);
+    for (size_t i = 0; i < extraThreads; ++i)
+        workers.emplace_back(work);
+    work();
+    for (auto &worker : workers)
+        worker.join();
+}
+
+#endif //DUCKHUNT_PARALLEL_HPP
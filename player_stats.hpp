@@ -1,19 +1,33 @@
 #ifndef DUCKHUNT_PLAYER_STATS_HPP
 #define DUCKHUNT_PLAYER_STATS_HPP
 
-#include <vector>
+#include <array>
 
+/// A round is ten slots on the HUD, each standing for ::ducks_per_slot ducks.
 struct Player_Stats {
+    /// The slots whose ducks were shot.
     std::array<bool, 10> ducks_hit;
-    /// The ducks currently on screen, e.g. duck 5 and duck 6.
-    std::vector<int> ducks_current;
+    /// The slots whose ducks are currently on screen, bit i is set for slot i, e.g. slot 5 and slot 6.
+    unsigned int ducks_current;
+    /// The number of slots that must be hit to go on to the next round.
     int ducks_needed;
-    /// The next duck to release
+    /// The next slot to release ducks into.
     int duck_next;
+    /// The number of ducks released at once.
     int ducks_simultaneous;
+    /// The number of ducks each slot stands for, 1 except in the endless game.
+    int ducks_per_slot;
+    /// The ducks shot in each slot, a slot is hit once at least half of its ducks are.
+    std::array<int, 10> slot_hits;
     int round;
     int score;
     int shots_left;
+    /// The shots given for each release of ducks.
+    int shots_per_flight;
+    /// Whether this is the endless game, where the ducks multiply every round and the game is never lost.
+    bool endless;
+    /// The last round to play, 0 for no limit.
+    int last_round;
 };
 
 #endif //DUCKHUNT_PLAYER_STATS_HPP
@@ -0,0 +1,153 @@
+#ifndef DUCKHUNT_RECORDING_HPP
+#define DUCKHUNT_RECORDING_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include "SDL2/SDL.h"
+
+// A recording is a header followed by one record per frame and one per input event, all in native byte order.
+//   header: "DHREC" 5 bytes, version uint8, seed uint32
+//   frame:  'F', frame time in ms double
+//   event:  'E', type uint32, timestamp uint32, button uint8, x or key int32, y int32
+// Event timestamps are in ms of game time, see Session::gameTime(), so replays resolve shots the same way.
+
+const char recordingMagic[5] = {'D', 'H', 'R', 'E', 'C'};
+const uint8_t recordingVersion = 2;
+const char frameRecord = 'F';
+const char eventRecord = 'E';
+
+/// Writes the seed, frame times and input events of a session to a file, to be played back by a Replayer.
+class Recorder {
+private:
+    std::ofstream file;
+
+public:
+    /// Creates the recording file.
+    /// \param filename The file to write to.
+    /// \param seed The seed of the session's random number generator.
+    Recorder(const std::string &filename, uint32_t seed) : file(filename, std::ios::binary | std::ios::trunc) {
+        file.write(recordingMagic, sizeof(recordingMagic));
+        write(recordingVersion);
+        write(seed);
+    }
+
+    bool isOpen() {
+        return file.good();
+    }
+
+    /// Records the start of a frame.
+    /// \param deltaTime The time since the last frame in ms.
+    void frame(double deltaTime) {
+        write(frameRecord);
+        write(deltaTime);
+    }
+
+    /// Records an input event handled during the current frame.
+    void event(const SDL_Event &e) {
+        write(eventRecord);
+        write(e.type);
+        write(e.common.timestamp);
+        int32_t a = 0, b = 0;
+        uint8_t button = 0;
+        if (e.type == SDL_MOUSEBUTTONDOWN || e.type == SDL_MOUSEBUTTONUP) {
+            button = e.button.button;
+            a = e.button.x;
+            b = e.button.y;
+        }
+        else if (e.type == SDL_KEYDOWN || e.type == SDL_KEYUP)
+            a = e.key.keysym.sym;
+        write(button);
+        write(a);
+        write(b);
+    }
+
+    void flush() {
+        file.flush();
+    }
+
+private:
+    template<typename T>
+    void write(const T &value) {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+};
+
+/// Plays back a file written by a Recorder: its seed, then the same frame times and input events frame by frame.
+class Replayer {
+private:
+    std::ifstream file;
+    uint32_t seed = 0;
+    bool valid = false;
+
+public:
+    /// Opens a recording and reads its header.
+    /// \param filename The file to read.
+    explicit Replayer(const std::string &filename) : file(filename, std::ios::binary) {
+        char magic[sizeof(recordingMagic)];
+        uint8_t version = 0;
+        file.read(magic, sizeof(magic));
+        read(&version);
+        read(&seed);
+        valid = file.good() && std::equal(magic, magic + sizeof(magic), recordingMagic) && version == recordingVersion;
+    }
+
+    /// Whether the file is a recording this version can play.
+    bool isValid() {
+        return valid;
+    }
+
+    uint32_t getSeed() {
+        return seed;
+    }
+
+    /// Reads the next frame.
+    /// \param deltaTime The recorded time since the last frame in ms.
+    /// \return false if the recording has ended.
+    bool frame(double* deltaTime) {
+        // Skip events the recorded session had not handled when its frame ended
+        while (file.peek() == eventRecord) {
+            SDL_Event skipped{};
+            event(&skipped);
+        }
+        char tag = 0;
+        return read(&tag) && tag == frameRecord && read(deltaTime);
+    }
+
+    /// Reads the next input event of the current frame.
+    /// \param e The event to fill in.
+    /// \return false if there are no more events in this frame.
+    bool event(SDL_Event* e) {
+        if (file.peek() != eventRecord)
+            return false;
+        file.get();
+
+        uint32_t type = 0, timestamp = 0;
+        uint8_t button = 0;
+        int32_t a = 0, b = 0;
+        if (!(read(&type) && read(&timestamp) && read(&button) && read(&a) && read(&b)))
+            return false;
+
+        *e = SDL_Event{};
+        e->type = type;
+        e->common.timestamp = timestamp;
+        if (type == SDL_MOUSEBUTTONDOWN || type == SDL_MOUSEBUTTONUP) {
+            e->button.button = button;
+            e->button.state = type == SDL_MOUSEBUTTONDOWN ? SDL_PRESSED : 0;
+            e->button.clicks = 1;
+            e->button.x = a;
+            e->button.y = b;
+        }
+        else if (type == SDL_KEYDOWN || type == SDL_KEYUP)
+            e->key.keysym.sym = a;
+        return true;
+    }
+
+private:
+    template<typename T>
+    bool read(T* value) {
+        return static_cast<bool>(file.read(reinterpret_cast<char*>(value), sizeof(T)));
+    }
+};
+
+#endif //DUCKHUNT_RECORDING_HPP
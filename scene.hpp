@@ -2,30 +2,59 @@
 #define DUCKHUNT_CUTSCENE_HPP
 
 #include <algorithm>
+#include <memory>
+#include <vector>
 #include <SDL2/SDL.h>
 #include "dog.hpp"
 #include "textures.hpp"
 #include "message.hpp"
+#include "session.hpp"
+#include "trace.hpp"
+#include "texture_sets.hpp"
+#include "texture_watcher.hpp"
+#include "soak.hpp"
+
+class SceneStack;
 
 class Scene {
+public:
+    /// The length of a simulation step in ms.
+    static constexpr double simulationStep = 1000.0 / 120.0;
+    /// The longest frame that is simulated in full, so a stall does not cause a burst of simulation steps.
+    static constexpr double maxFrameTime = 250.0;
+
+private:
+    friend class SceneStack;
+    /// The stack running this scene.
+    SceneStack* stack;
+
 protected:
-    Uint64 now;
-    Uint64 last;
+    Session* session;
+    /// How far rendering is between the last simulation step and the next, from 0 to 1.
+    double interpolation;
     Drawer* drawer;
     Player_Stats* player_stats;
     Textures* textures;
 
 public:
-    Scene(Drawer* drawer, Player_Stats* player_stats, Textures* textures) {
+    Scene(Session* session, Drawer* drawer, Player_Stats* player_stats, Textures* textures) {
+        this->session = session;
         this->drawer = drawer;
         this->player_stats = player_stats;
         this->textures = textures;
-        now = 0;
-        last = 0;
+        interpolation = 1.0;
+        stack = nullptr;
     }
 
     explicit Scene(Scene* other) :
-        Scene(other->getDrawer(), other->getPlayerStats(), other->getTextures()) {}
+        Scene(other->getSession(), other->getDrawer(), other->getPlayerStats(), other->getTextures()) {}
+
+    virtual ~Scene() = default;
+
+    /// The name of this environment, e.g. in traces.
+    virtual const char* name() {
+        return "Scene";
+    }
 
     /// Renders the background for this environment.
     /// \param deltaTime The time since the last frame in ms.
@@ -64,59 +93,209 @@ public:
     virtual bool handleInput(SDL_Event e) {
         if (e.type == SDL_QUIT)
             throw QuitTrigger();
+        if (e.type == SDL_RENDER_TARGETS_RESET || e.type == SDL_RENDER_DEVICE_RESET)
+            drawer->invalidateUI();
+        if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F3)
+            session->frameTimer.overlayVisible = !session->frameTimer.overlayVisible;
+        if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F4)
+            TRACE_DUMP(traceFile);
+        if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F5 && session->textureSets != nullptr)
+            session->textureSets->toggle();
+        return false;
+    }
+
+    /// Where an automatic shooter should click in this environment.
+    /// \param x The x coordinate of the target in the world.
+    /// \param y The y coordinate of the target in the world.
+    /// \return false if there is nothing to click on.
+    virtual bool autoTarget(int* x, int* y) {
+        return false;
+    }
+
+    /// Called after each frame that this scene was on top of the stack for from start to end.
+    /// \param ms The time the frame took.
+    virtual void frameTimed(double ms) {}
+
+    /// Called when a scene shown on top of this one with ::show(std::unique_ptr<Scene> scene) has ended.
+    /// \return true if environment should end, false otherwise.
+    /// \throws QuitTrigger if the user tried to quit the game.
+    virtual bool resume() {
         return false;
     }
 
-    /// Starts the environment.
+    /// Starts the environment, running it and any scenes it shows until it ends.
     /// \throws QuitTrigger if the user tried to quit the game.
-    void start() {
-        now = SDL_GetPerformanceCounter();
+    void start();
+
+    Session* getSession() {
+        return session;
+    }
+
+    Drawer* getDrawer() {
+        return drawer;
+    }
+
+    Player_Stats* getPlayerStats() {
+        return player_stats;
+    }
+
+    Textures* getTextures() {
+        return textures;
+    }
+
+protected:
+    /// Shows another scene on top of this one. It takes over input, updates and rendering from the next frame
+    /// until it ends, then ::resume() is called.
+    /// \param scene The scene to show.
+    void show(std::unique_ptr<Scene> scene);
+};
+
+/// Runs a scene and the scenes shown on top of it from a single loop, so every frame has one clock tick, one
+/// event pump and one present whichever scene is on top.
+class SceneStack {
+private:
+    Session* session;
+    Scene* root;
+    std::vector<std::unique_ptr<Scene>> shown;
+    /// Whether a scene was shown or ended during the current frame.
+    bool changed;
+
+public:
+    explicit SceneStack(Session* session) {
+        this->session = session;
+        root = nullptr;
+        changed = false;
+    }
+
+    /// Adds a scene to the top of the stack.
+    void push(std::unique_ptr<Scene> scene) {
+        scene->stack = this;
+        shown.push_back(std::move(scene));
+        changed = true;
+    }
+
+    /// Runs a scene until it ends.
+    /// Updates run in fixed steps of Scene::simulationStep ms, however long a frame takes, and rendering is passed
+    /// Scene::interpolation to draw moving objects between the last two steps.
+    /// \param scene The scene to run, which is not owned by the stack.
+    /// \throws QuitTrigger if the user tried to quit the game, or a soak test has run for its duration.
+    void run(Scene* scene) {
+        root = scene;
+        root->stack = this;
+        shown.clear();
+
         double deltaTime;
+        double accumulator = 0.0;
+        FrameTimer &timer = session->frameTimer;
 
         SDL_Event e{};
         while (true) {
-            last = now;
-            now = SDL_GetPerformanceCounter();
-            deltaTime = ((now - last)*1000 / (double)SDL_GetPerformanceFrequency() );
+            deltaTime = std::min(session->tick(), Scene::maxFrameTime);
+            timer.beginFrame();
+            session->allocationStats.beginFrame();
+            changed = false;
+            const char* frameScene = top()->name();
+            TRACE_ZONE(frameScene);
+
+            // Textures loaded in the background are swapped in before anything uses this frame's textures
+            if (session->textureSets != nullptr && session->textureSets->apply(top()->drawer->getRenderer()))
+                top()->drawer->invalidateUI();
+            if (session->textureWatcher != nullptr && session->textureWatcher->apply(top()->drawer->getRenderer()))
+                top()->drawer->invalidateUI();
+
+            // Scripted input
+            int targetX, targetY;
+            if (session->shooter != nullptr && session->shooter->ready(deltaTime) && top()->autoTarget(&targetX, &targetY)) {
+                session->shooter->aim(&targetY);
+                top()->drawer->worldPointToScreenPoint(&targetX, &targetY);
+                session->pushClick(targetX, targetY);
+            }
 
-            // User input
-            while (SDL_PollEvent(&e) != 0) {
-                if (handleInput(e))
-                    return;
+            // User input, the rest of the events are left to the next frame when a scene ends
+            while (session->pollEvent(&e)) {
+                if (top()->handleInput(e)) {
+                    if (!pop())
+                        return;
+                    break;
+                }
             }
+            timer.endPhase(PHASE_INPUT);
 
             // Game Object updates
-            if (update(deltaTime))
-                return;
+            accumulator += deltaTime;
+            while (accumulator >= Scene::simulationStep) {
+                accumulator -= Scene::simulationStep;
+                if (top()->update(Scene::simulationStep) && !pop())
+                    return;
+            }
+            timer.endPhase(PHASE_UPDATE);
 
             // Rendering
-            SDL_RenderClear(drawer->getRenderer()); // Flush buffer
-
-            if (renderBackground(deltaTime))
-                return;
-
-            if (renderForeground(deltaTime))
-                return;
-
-            renderUI(deltaTime);
+            Scene* scene = top();
+            Drawer* drawer = scene->drawer;
+            scene->interpolation = accumulator / Scene::simulationStep;
+            drawer->clear(); // Flush buffer
+            drawer->showFrameTimes(timer.overlayVisible ? &timer : nullptr, &scene->textures->font_white);
+
+            drawer->setLayer(LAYER_BACKGROUND);
+            if (scene->renderBackground(deltaTime)) {
+                if (!pop())
+                    return;
+                continue;
+            }
+            timer.endPhase(PHASE_BACKGROUND);
 
-            SDL_RenderPresent(drawer->getRenderer()); // Update screen
+            drawer->setLayer(LAYER_FOREGROUND);
+            if (scene->renderForeground(deltaTime)) {
+                if (!pop())
+                    return;
+                continue;
+            }
+            timer.endPhase(PHASE_FOREGROUND);
+
+            drawer->setLayer(LAYER_UI);
+            scene->renderUI(deltaTime);
+            timer.endPhase(PHASE_UI);
+
+            drawer->present(); // Update screen
+            if (session->inputLatency != nullptr)
+                session->inputLatency->presented();
+            timer.endPhase(PHASE_PRESENT);
+            session->allocationStats.endFrame(frameScene, !changed);
+            timer.endFrame(deltaTime, session->allocationStats.lastFrame());
+            if (!changed)
+                top()->frameTimed(timer.lastFrame());
+            if (session->soak != nullptr && session->soak->frame(timer, session->gamesPlayed, std::cout))
+                throw QuitTrigger();
         }
     }
 
-    Drawer* getDrawer() {
-        return drawer;
-    }
-
-    Player_Stats* getPlayerStats() {
-        return player_stats;
+private:
+    Scene* top() {
+        return shown.empty() ? root : shown.back().get();
     }
 
-    Textures* getTextures() {
-        return textures;
+    /// Ends the top scene and resumes the one below it, which may end in turn.
+    /// \return false if the root scene has ended.
+    bool pop() {
+        changed = true;
+        while (!shown.empty()) {
+            shown.pop_back();
+            if (!top()->resume())
+                return true;
+        }
+        return false;
     }
 };
 
+inline void Scene::start() {
+    SceneStack(session).run(this);
+}
+
+inline void Scene::show(std::unique_ptr<Scene> scene) {
+    stack->push(std::move(scene));
+}
+
 enum IntroCutSceneState {
     SNIFFING,
     JUMPING,
@@ -132,12 +311,16 @@ private:
     RoundMessage roundMessage;
 
 public:
-    IntroCutScene(Drawer *drawer, Player_Stats *player_stats, Textures *textures)
-        : Scene(drawer, player_stats, textures), dogSniffing(textures->dog_sniffing, 7),
-          dogJumping(textures->dog_jumping, 90), roundMessage(189, 52, 2500.0, textures->ui_message_round, 1, textures->ui_numbers_white) {
+    IntroCutScene(Session *session, Drawer *drawer, Player_Stats *player_stats, Textures *textures)
+        : Scene(session, drawer, player_stats, textures), dogSniffing(textures->dog_sniffing, 7),
+          dogJumping(textures->dog_jumping, 90), roundMessage(189, 52, 2500.0, textures->ui_message_round, 1, &textures->font_white) {
         cutSceneState = SNIFFING;
     }
 
+    const char* name() override {
+        return "IntroCutScene";
+    }
+
     bool handleInput(SDL_Event e) override {
         if (Scene::handleInput(e))
             return true;
@@ -193,6 +376,10 @@ public:
           dogSuccess(std::max(120, std::min(duckX, 210)), 157, 120, textures->dog_success, duck1Colour, duck2Colour, 0.1) {
     }
 
+    const char* name() override {
+        return "SuccessCutScene";
+    }
+
     bool renderBackground(double deltaTime) override {
         Scene::renderBackground(deltaTime);
 
@@ -206,7 +393,11 @@ private:
     DogFailure dogFailure;
 public:
     explicit FailureCutScene(Scene* env)
-        : Scene(env), dogFailure(213, 157, 120, textures->dog_failure, 0.1, 10) {
+        : Scene(env), dogFailure(213, 157, 120, textures, 0.1, 10) {
+    }
+
+    const char* name() override {
+        return "FailureCutScene";
     }
 
     bool renderBackground(double deltaTime) override {
@@ -216,27 +407,30 @@ public:
     }
 };
 
-enum GameType {SINGLE, DOUBLE};
+enum GameType {SINGLE, DOUBLE, ENDLESS};
 
 /// The main menu environment.
 class MainMenu : public Scene {
 private:
     GameType gameType;
-    std::string highScore;
+    NumberLabel highScore;
 
 public:
-    MainMenu(Drawer *drawer, Textures* textures, int highScore)
-        : Scene(drawer, nullptr, textures) {
-        this->highScore = std::to_string(highScore);
+    MainMenu(Session *session, Drawer *drawer, Textures* textures, int highScore)
+        : Scene(session, drawer, nullptr, textures) {
+        this->highScore.set(&textures->font_green, highScore);
         gameType = SINGLE;
     }
 
+    const char* name() override {
+        return "MainMenu";
+    }
+
     bool handleInput(SDL_Event e) override {
         if (Scene::handleInput(e))
             return true;
         if (e.type == SDL_MOUSEBUTTONDOWN) {
-            int mX, mY;
-            SDL_GetMouseState(&mX, &mY);
+            int mX = e.button.x, mY = e.button.y;
             drawer->screenPointToWorldPoint(&mX, &mY);
             // Start single duck game
             if (mX > 106 && mX < 182 && mY > 127 && mY < 196) {
@@ -249,9 +443,21 @@ public:
                 return true;
             }
         }
+        // The endless game has no button
+        if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_e) {
+            gameType = ENDLESS;
+            return true;
+        }
         return false;
     }
 
+    bool autoTarget(int* x, int* y) override {
+        // The single duck game button
+        *x = 144;
+        *y = 161;
+        return true;
+    }
+
     bool renderBackground(double deltaTime) override {
         drawer->renderTexture(textures->main_menu_background, 0, 0);
         return false;
@@ -262,8 +468,7 @@ public:
     }
 
     void renderUI(double deltaTime) override {
-        for (int i = 0; i < highScore.size(); ++i)
-            drawer->renderCharacter(textures->ui_numbers_green, highScore[i], 238 + i * 8, 209);
+        drawer->renderNumber(highScore, 238, 209);
     }
 
     GameType resultGameType() {
@@ -271,39 +476,41 @@ public:
     }
 };
 
-/// When the duck flew away after the player runs out of bullets.
+/// When the ducks fly away after the player runs out of bullets.
 class FlyAwayDuck : public Scene {
 private:
-    Duck* duck1;
-    Duck* duck2;
+    std::vector<Duck>* ducks;
 
 public:
-    FlyAwayDuck(Scene* env, Duck* duck1, Duck* duck2 = nullptr) : Scene(env) {
-        this->duck1 = duck1;
-        this->duck2 = duck2;
+    /// \param ducks The ducks on screen, the living ones fly up and the rest keep falling.
+    FlyAwayDuck(Scene* env, std::vector<Duck>* ducks) : Scene(env) {
+        this->ducks = ducks;
+        for (auto &duck : *ducks)
+            if (duck.alive)
+                duck.flyUp();
+    }
 
-        this->duck1->flyUp();
-        if (this->duck2 != nullptr)
-            this->duck2->flyUp();
+    const char* name() override {
+        return "FlyAwayDuck";
     }
 
     bool update(double deltaTime) override {
         Scene::update(deltaTime);
 
-        duck1->update(deltaTime);
-        if (duck2 != nullptr)
-            duck2->update(deltaTime);
-
-        if ((!duck1->isOnScreen() && duck2 == nullptr) || (duck2 != nullptr && !duck2->isOnScreen()))
-            return true;
+        bool flying = false;
+        for (auto &duck : *ducks) {
+            duck.storePosition();
+            duck.update(deltaTime);
+            flying = flying || (duck.alive && duck.isOnScreen());
+        }
+        return !flying;
     }
 
     bool renderBackground(double deltaTime) override {
         drawer->renderTexture(textures->background_fail, 0, 0);
 
-        duck1->render(drawer, deltaTime);
-        if (duck2 != nullptr)
-            duck2->render(drawer, deltaTime);
+        for (auto &duck : *ducks)
+            duck.render(drawer, deltaTime, interpolation);
 
         return false;
     }
@@ -323,7 +530,11 @@ private:
     DogGameOver dogGameOver;
 
 public:
-    explicit GameOver(Scene* env) : Scene(env), dogGameOver(213, 157, 120, textures->dog_failure, 0.1, 10) {
+    explicit GameOver(Scene* env) : Scene(env), dogGameOver(213, 157, 120, textures, 0.1, 10) {
+    }
+
+    const char* name() override {
+        return "GameOver";
     }
 
     bool renderBackground(double deltaTime) override {
@@ -355,12 +566,16 @@ private:
 public:
     explicit DuckUIFlash(Scene* env) : Scene(env), timer(500.0) {
         stats_template = *player_stats;
-        stats_template.ducks_current = {};
+        stats_template.ducks_current = 0;
         stats = stats_template;
         showTemplate = true;
         flashes = 0;
     }
 
+    const char* name() override {
+        return "DuckUIFlash";
+    }
+
     bool update(double deltaTime) override {
         Scene::update(deltaTime);
 
@@ -368,8 +583,6 @@ public:
     }
 
     void renderUI(double deltaTime) override {
-        Scene::renderUI(deltaTime);
-
         if (timer.tick(deltaTime)) {
             for (int i = 0; i < stats.ducks_hit.size(); ++i) {
                 if (showTemplate)
@@ -396,6 +609,10 @@ public:
         done = false;
     }
 
+    const char* name() override {
+        return "DuckUICoalesce";
+    }
+
     bool update(double deltaTime) override {
         Scene::update(deltaTime);
 
@@ -403,8 +620,6 @@ public:
     }
 
     void renderUI(double deltaTime) override {
-        Scene::renderUI(deltaTime);
-
         if (timer.tick(deltaTime)) {
             done = true;
             for (int i = 1; i < player_stats->ducks_hit.size(); ++i)
@@ -0,0 +1,344 @@
+#ifndef DUCKHUNT_SESSION_HPP
+#define DUCKHUNT_SESSION_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "SDL2/SDL.h"
+#include "errors.hpp"
+#include "timer.hpp"
+#include "recording.hpp"
+#include "frame_timer.hpp"
+#include "allocations.hpp"
+#include "input_latency.hpp"
+
+class TextureSets;
+class TextureWatcher;
+class SoakMonitor;
+
+/// Clicks on targets by itself, standing in for a player in headless runs.
+class AutoShooter {
+private:
+    Timer timer;
+    double accuracy;
+    std::mt19937 mt;
+
+public:
+    /// \param reactionTime The time between shots in ms, or from seeing a target to shooting at it.
+    /// \param accuracy The chance of a shot being aimed at its target, from 0 to 1.
+    /// \param seed The seed for deciding which shots miss.
+    AutoShooter(double reactionTime, double accuracy, unsigned int seed) : timer(reactionTime), mt(seed) {
+        this->accuracy = accuracy;
+    }
+
+    /// Advances the shooter's clock.
+    /// \param deltaTime The time since the last frame in ms.
+    /// \return true if it is time to shoot.
+    bool ready(double deltaTime) {
+        return timer.tick(deltaTime);
+    }
+
+    /// Starts the reaction time over on seeing a target, so the shot is ready a reaction time later.
+    void sight() {
+        timer.reset();
+    }
+
+    /// Decides where to shoot, moving the point above the target for shots that miss.
+    /// \param y The y coordinate of the target in the world, replaced by where to shoot.
+    void aim(int* y) {
+        std::uniform_real_distribution<double> dist(0.0, 1.0);
+        if (dist(mt) >= accuracy)
+            *y -= 60;
+    }
+};
+
+/// How the game is being run, along with the frame clock and input shared by every scene.
+class Session {
+private:
+    Uint64 now = 0;
+    bool clockStarted = false;
+    /// The game time in ms, the sum of every frame's time, which replays reproduce.
+    double clock = 0.0;
+    /// How many ms the game clock moved on per real ms in the last frame, 1 unless frames take a fixed time.
+    double gameRate = 1.0;
+    /// The game time of the last frame in ms.
+    double lastFrameTime = 0.0;
+    /// Scripted events waiting to be handled, a vector so queueing them does not allocate once it has grown.
+    std::vector<SDL_Event> scriptedEvents;
+    std::unique_ptr<Recorder> recorder;
+    std::unique_ptr<Replayer> replayer;
+    std::string recordPath;
+    std::string replayPath;
+    std::string frameTimesPath;
+    bool hasSeed = false;
+
+public:
+    /// The seed of ::random, chosen at random unless given on the command line or read from a replay.
+    uint32_t seed = 0;
+    /// The one random number generator for everything that affects the game.
+    std::mt19937 random;
+    /// true when running without a window, renderer or display.
+    bool headless = false;
+    /// The time every frame is treated as taking in ms, or 0 to use the real clock.
+    double fixedFrameTime = 0.0;
+    /// The number of games to play before quitting, 0 for no limit.
+    int gamesToPlay = 0;
+    int gamesPlayed = 0;
+    /// Times the phases of every frame, whichever scene is running.
+    FrameTimer frameTimer;
+    /// Counts the heap allocations of every frame, when built with DUCKHUNT_TRACK_ALLOCATIONS.
+    AllocationStats allocationStats;
+    /// A scene whose steady frames must not allocate, checked when the game ends. Empty for no check.
+    std::string allocationCheckScene;
+    /// Swaps the texture set between frames, may be nullptr.
+    TextureSets* textureSets = nullptr;
+    /// Reloads changed texture files between frames, nullptr unless ::watchTextures is set.
+    TextureWatcher* textureWatcher = nullptr;
+    /// Whether to reload textures when their files change, for working on them.
+    bool watchTextures = false;
+    /// Whether to play the endless game whichever game is picked on the menu.
+    bool endless = false;
+    /// The number of ducks in the swarm attraction mode, 0 to play the game instead.
+    int swarmSize = 0;
+    /// Plays the game in place of the user, may be nullptr.
+    AutoShooter* shooter = nullptr;
+    /// Samples the game through a soak test, nullptr unless ::soakDuration is set.
+    SoakMonitor* soak = nullptr;
+    /// Whether to measure the time from clicks to the frames that show them.
+    bool measureInputLatency = false;
+    /// Times clicks to the present of the frames that show them, nullptr unless ::measureInputLatency is set.
+    InputLatency* inputLatency = nullptr;
+
+    // Settings for the soak test, which plays headless games against an offscreen renderer for ::soakDuration
+    /// How long to run the soak test for in seconds, 0 for no soak test.
+    double soakDuration = 0.0;
+    /// The time between samples in seconds.
+    double soakInterval = 60.0;
+    /// How much a metric may grow over the soak test, as a fraction of its value.
+    double soakThreshold = 0.1;
+
+    // Settings for the automatic shooter
+    double reactionTime = 400.0;
+    double accuracy = 0.75;
+
+    /// Reads the command line.
+    /// \return false if the arguments are not valid.
+    bool parseArguments(int argc, char* argv[]) {
+        try {
+            return readArguments(argc, argv);
+        }
+        catch (const std::logic_error& e) {
+            std::cout << "Invalid argument value: " << e.what() << std::endl;
+            return false;
+        }
+    }
+
+    /// Seeds the random number generator and opens the recording or replay files.
+    /// \return false if a file could not be opened.
+    bool open() {
+        if (!replayPath.empty()) {
+            replayer = std::make_unique<Replayer>(replayPath);
+            if (!replayer->isValid()) {
+                std::cout << "Could not read replay " << replayPath << std::endl;
+                return false;
+            }
+            seed = replayer->getSeed();
+            hasSeed = true;
+            // The recorded input already contains any automatic shots
+            shooter = nullptr;
+        }
+        // Headless runs play a single game unless told otherwise, replays play until the recording ends and soak tests
+        // until their time is up
+        if (headless && gamesToPlay == 0 && replayer == nullptr && soakDuration <= 0.0)
+            gamesToPlay = 1;
+        if (!hasSeed)
+            seed = std::random_device()();
+        random.seed(seed);
+
+        if (!recordPath.empty()) {
+            recorder = std::make_unique<Recorder>(recordPath, seed);
+            if (!recorder->isOpen()) {
+                std::cout << "Could not write recording " << recordPath << std::endl;
+                return false;
+            }
+        }
+
+        if (!frameTimesPath.empty() && !frameTimer.openCSV(frameTimesPath)) {
+            std::cout << "Could not write frame times " << frameTimesPath << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool isReplaying() {
+        return replayer != nullptr;
+    }
+
+    /// Whether all of the requested games have been played.
+    bool isFinished() {
+        return gamesToPlay > 0 && gamesPlayed >= gamesToPlay;
+    }
+
+    /// The time the game has run for in ms, as of the last ::tick(). Event timestamps are given in this time.
+    double gameTime() const {
+        return clock;
+    }
+
+    /// Converts how long an event waited in real time to game time, at the rate of the last frame, which differs when
+    /// frames take a fixed time.
+    /// Events wait at most a frame to be handled, so the game time is capped at the last frame's. That also keeps a ms
+    /// of rounding from becoming hundreds of ms of game time when fixed frames run far faster than real time.
+    /// \param realTime A real duration in ms.
+    /// \return The game time that passes in it in ms.
+    double gameTimeOf(double realTime) const {
+        return std::min(realTime * gameRate, lastFrameTime);
+    }
+
+    /// Measures the time since the last frame.
+    /// \return The time since the last call in ms, or the fixed frame time.
+    /// \throws QuitTrigger if a replay has ended.
+    double tick() {
+        double deltaTime;
+        if (replayer != nullptr) {
+            if (!replayer->frame(&deltaTime))
+                throw QuitTrigger();
+            clock += deltaTime;
+            return deltaTime;
+        }
+
+        Uint64 last = now;
+        now = SDL_GetPerformanceCounter();
+        if (!clockStarted) {
+            clockStarted = true;
+            deltaTime = 0.0;
+        }
+        else {
+            double realTime = (now - last) * 1000 / (double)SDL_GetPerformanceFrequency();
+            deltaTime = fixedFrameTime > 0.0 ? fixedFrameTime : realTime;
+            gameRate = realTime > 0.0 ? deltaTime / realTime : 1.0;
+        }
+
+        if (recorder != nullptr)
+            recorder->frame(deltaTime);
+        clock += deltaTime;
+        lastFrameTime = deltaTime;
+        return deltaTime;
+    }
+
+    /// Gets the next input event, scripted events first.
+    /// \param e The event to fill in.
+    /// \return true if there was an event.
+    bool pollEvent(SDL_Event* e) {
+        if (replayer != nullptr) {
+            // Still let the user close the window during a replay
+            if (!headless && SDL_PollEvent(e) != 0 && e->type == SDL_QUIT)
+                return true;
+            return replayer->event(e);
+        }
+
+        if (!scriptedEvents.empty()) {
+            *e = scriptedEvents.front();
+            scriptedEvents.erase(scriptedEvents.begin());
+        }
+        else if (headless || SDL_PollEvent(e) == 0)
+            return false;
+
+        // SDL stamps events in real ms of SDL_GetTicks(), which tells how long the event waited. The stamp is replaced
+        // by the game time it happened at, so the scenes and replays place the event the same way. SDL_GetTicks() only
+        // counts whole ms, so the wait can be 1 ms out either way, and the game time is rounded to the nearest ms.
+        auto waited = static_cast<double>(std::max(0, static_cast<int32_t>(SDL_GetTicks() - e->common.timestamp)));
+        if (e->type == SDL_MOUSEBUTTONDOWN && inputLatency != nullptr)
+            inputLatency->clickHandled(waited);
+        e->common.timestamp = static_cast<Uint32>(std::lround(std::max(0.0, clock - gameTimeOf(waited))));
+
+        // Mouse movement does not affect the game, so it is left out of recordings
+        if (recorder != nullptr && e->type != SDL_MOUSEMOTION)
+            recorder->event(*e);
+        return true;
+    }
+
+    /// Queues a scripted left click, happening now.
+    /// \param x The x coordinate in window pixels.
+    /// \param y The y coordinate in window pixels.
+    void pushClick(int x, int y) {
+        SDL_Event e{};
+        e.type = SDL_MOUSEBUTTONDOWN;
+        e.button.button = SDL_BUTTON_LEFT;
+        e.button.state = SDL_PRESSED;
+        e.button.clicks = 1;
+        e.button.x = x;
+        e.button.y = y;
+        e.button.timestamp = SDL_GetTicks();
+        scriptedEvents.push_back(e);
+    }
+
+private:
+    bool readArguments(int argc, char* argv[]) {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--headless") {
+                headless = true;
+                if (fixedFrameTime <= 0.0)
+                    fixedFrameTime = 1000.0 / 60.0;
+            }
+            else if (arg == "--soak" && hasValue) {
+                soakDuration = std::stod(argv[++i]) * 60.0;
+                headless = true;
+                if (fixedFrameTime <= 0.0)
+                    fixedFrameTime = 1000.0 / 60.0;
+            }
+            else if (arg == "--soak-interval" && hasValue)
+                soakInterval = std::stod(argv[++i]);
+            else if (arg == "--soak-threshold" && hasValue)
+                soakThreshold = std::stod(argv[++i]) / 100.0;
+            else if (arg == "--games" && hasValue)
+                gamesToPlay = std::stoi(argv[++i]);
+            else if (arg == "--frame-time" && hasValue)
+                fixedFrameTime = std::stod(argv[++i]);
+            else if (arg == "--reaction-time" && hasValue)
+                reactionTime = std::stod(argv[++i]);
+            else if (arg == "--accuracy" && hasValue)
+                accuracy = std::stod(argv[++i]);
+            else if (arg == "--seed" && hasValue) {
+                seed = static_cast<uint32_t>(std::stoul(argv[++i]));
+                hasSeed = true;
+            }
+            else if (arg == "--record" && hasValue)
+                recordPath = argv[++i];
+            else if (arg == "--replay" && hasValue)
+                replayPath = argv[++i];
+            else if (arg == "--frame-times" && hasValue)
+                frameTimesPath = argv[++i];
+            else if (arg == "--show-frame-times")
+                frameTimer.overlayVisible = true;
+            else if (arg == "--watch-textures")
+                watchTextures = true;
+            else if (arg == "--input-latency")
+                measureInputLatency = true;
+            else if (arg == "--endless")
+                endless = true;
+            else if (arg == "--swarm" && hasValue)
+                swarmSize = std::stoi(argv[++i]);
+            else if (arg == "--check-allocations" && hasValue)
+                allocationCheckScene = argv[++i];
+            else {
+                std::cout << "Unknown argument: " << arg << std::endl;
+                std::cout << "Usage: " << argv[0] << " [--headless] [--games N] [--frame-time MS]"
+                          << " [--reaction-time MS] [--accuracy 0-1] [--seed N] [--record FILE | --replay FILE]"
+                          << " [--frame-times FILE] [--show-frame-times] [--watch-textures]"
+                          << " [--input-latency] [--endless] [--swarm N] [--check-allocations SCENE]"
+                          << " [--soak MINUTES [--soak-interval SECONDS] [--soak-threshold PERCENT]]" << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+#endif //DUCKHUNT_SESSION_HPP
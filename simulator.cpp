@@ -0,0 +1,366 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include "cleanup.hpp"
+#include "level.hpp"
+#include "parallel.hpp"
+#include "session.hpp"
+
+// Plays a large number of games with automatic shooters, to see how changes to the scoring, the ducks needed per
+// round and the duck speeds play out. Nothing is drawn, so a game takes well under a millisecond, e.g.
+//   duckhunt_simulator --games 1000000 --shooter 400:0.75 --shooter 250:0.9 --out balance.json
+
+const int WORLD_WIDTH = 256 * 3;
+const int WORLD_HEIGHT = 224 * 3;
+/// The number of games played with one set of random number generators, and the unit of work handed to a thread.
+/// Results depend on the seed and the batch size but not on the number of threads.
+const int GAMES_PER_BATCH = 1000;
+
+/// How long an automatic shooter takes to shoot at a duck it has seen, and how often it hits where it aims.
+struct ShooterProfile {
+    double reactionTime;
+    double accuracy;
+};
+
+/// The end of one simulated game.
+struct GameResult {
+    int roundsCleared;
+    int score;
+    int shots;
+    int kills;
+};
+
+/// A histogram of values in buckets of a fixed width, which can be added to the histograms of other threads.
+class Distribution {
+private:
+    double bucketWidth;
+    std::vector<uint64_t> counts;
+    uint64_t total = 0;
+    double sum = 0.0;
+
+public:
+    explicit Distribution(double bucketWidth) {
+        this->bucketWidth = bucketWidth;
+    }
+
+    void add(double value) {
+        auto bucket = static_cast<size_t>(std::max(0.0, value) / bucketWidth);
+        if (bucket >= counts.size())
+            counts.resize(bucket + 1, 0);
+        counts[bucket]++;
+        total++;
+        sum += value;
+    }
+
+    void merge(const Distribution &other) {
+        if (other.counts.size() > counts.size())
+            counts.resize(other.counts.size(), 0);
+        for (size_t bucket = 0; bucket < other.counts.size(); ++bucket)
+            counts[bucket] += other.counts[bucket];
+        total += other.total;
+        sum += other.sum;
+    }
+
+    uint64_t size() const {
+        return total;
+    }
+
+    double mean() const {
+        return total > 0 ? sum / total : 0.0;
+    }
+
+    /// The value below which a fraction of the values fall, to the width of a bucket.
+    /// \param fraction From 0 to 1, e.g. 0.5 for the median.
+    double percentile(double fraction) const {
+        auto rank = static_cast<uint64_t>(std::ceil(fraction * total));
+        uint64_t seen = 0;
+        for (size_t bucket = 0; bucket < counts.size(); ++bucket) {
+            seen += counts[bucket];
+            if (seen >= std::max<uint64_t>(rank, 1))
+                return bucket * bucketWidth;
+        }
+        return 0.0;
+    }
+
+    /// Calls visit(value, count) for every bucket holding values, lowest first.
+    template<typename Visit>
+    void forEachBucket(Visit visit) const {
+        for (size_t bucket = 0; bucket < counts.size(); ++bucket)
+            if (counts[bucket] > 0)
+                visit(bucket * bucketWidth, counts[bucket]);
+    }
+};
+
+/// The distributions of the results of a number of games.
+struct SimulationStats {
+    Distribution roundsCleared{1.0};
+    Distribution score{100.0};
+    /// Shots fired per duck shot, over the games in which a duck was shot.
+    Distribution shotsPerKill{0.01};
+
+    void add(const GameResult &result) {
+        roundsCleared.add(result.roundsCleared);
+        score.add(result.score);
+        if (result.kills > 0)
+            shotsPerKill.add(static_cast<double>(result.shots) / result.kills);
+    }
+
+    void merge(const SimulationStats &other) {
+        roundsCleared.merge(other.roundsCleared);
+        score.merge(other.score);
+        shotsPerKill.merge(other.shotsPerKill);
+    }
+};
+
+/// Plays games by the rules of SinglePlayerGame, stepping its flights with Level::stepFlight(double deltaTime,
+/// int* landedX, DuckColours* landedColour) but without its scenes, as the cut scenes between flights only pass time.
+/// The shooter shoots a reaction time after seeing a duck, leading it by where it was heading then, as a player would,
+/// so ducks that turn in the meantime are missed.
+class SimulatedGame : public Level {
+public:
+    SimulatedGame(Session *session, Drawer *drawer, Player_Stats *player_stats, Textures *textures)
+        : Level(session, drawer, player_stats, textures) {}
+
+    /// Plays a game from its first round until a round is lost.
+    /// \param start The stats to start the game with, e.g. Level::singleDuckGame().
+    /// \param shooter The shooter playing the game.
+    /// \param maxRounds The round the game ends after, won or lost, so good shooters do not play forever.
+    GameResult play(const Player_Stats &start, AutoShooter* shooter, int maxRounds) {
+        *player_stats = start;
+        ducks.clear();
+        GameResult result{0, 0, 0, 0};
+        while (true) {
+            while (player_stats->duck_next < 10) {
+                launchDucks();
+                fly(shooter, &result);
+            }
+            if (ducksHit() < player_stats->ducks_needed)
+                break;
+            result.roundsCleared = player_stats->round;
+            if (player_stats->round >= maxRounds)
+                break;
+            startNewRound();
+        }
+        result.score = player_stats->score;
+        return result;
+    }
+
+private:
+    /// Shoots at the ducks in flight until they have all landed or flown away.
+    void fly(AutoShooter* shooter, GameResult* result) {
+        // Where the shooter last saw a duck, how fast it was going then, and how long ago that was in ms
+        bool sighted = false;
+        int targetX = 0, targetY = 0;
+        double seenSpeedX = 0.0, seenSpeedY = 0.0, sinceSighting = 0.0;
+        int landedX;
+        DuckColours landedColour;
+
+        while (true) {
+            FlightStep step = stepFlight(simulationStep, &landedX, &landedColour);
+            if (step == FLIGHT_LANDED)
+                return;
+            if (step == FLIGHT_TIMED_OUT)
+                break;
+            // Drawing the ducks would move their animations on
+            for (auto &duck : ducks)
+                duck.animate(simulationStep);
+
+            if (!sighted) {
+                sighted = autoTarget(&targetX, &targetY);
+                if (sighted) {
+                    // autoTarget(int* x, int* y) aims at the first living duck
+                    for (auto &duck : ducks)
+                        if (duck.alive) {
+                            seenSpeedX = (duck.x - duck.previousX) / simulationStep;
+                            seenSpeedY = (duck.y - duck.previousY) / simulationStep;
+                            break;
+                        }
+                    sinceSighting = 0.0;
+                    shooter->sight();
+                }
+                continue;
+            }
+            sinceSighting += simulationStep;
+            if (!shooter->ready(simulationStep))
+                continue;
+            sighted = false;
+            // Leads the duck by where it was heading when seen, so a duck that turned since then is missed
+            int x = targetX + static_cast<int>(seenSpeedX * sinceSighting);
+            int y = targetY + static_cast<int>(seenSpeedY * sinceSighting);
+            shooter->aim(&y);
+            result->shots++;
+            if (shoot(x, y, session->gameTime()) != nullptr)
+                result->kills++;
+            if (outOfShots())
+                break;
+        }
+        // The living ducks fly away, as FlyAwayDuck shows
+        player_stats->ducks_current = 0;
+        ducks.clear();
+        rebuildGrid();
+    }
+};
+
+/// Reads a shooter given as REACTION_TIME:ACCURACY, e.g. 400:0.75.
+/// \throws std::logic_error if the shooter is not valid.
+ShooterProfile parseShooter(const std::string &text) {
+    size_t colon = text.find(':');
+    if (colon == std::string::npos)
+        throw std::invalid_argument(text);
+    return {std::stod(text.substr(0, colon)), std::stod(text.substr(colon + 1))};
+}
+
+void writeResults(std::ostream &os, const std::vector<ShooterProfile> &shooters,
+                  const std::vector<SimulationStats> &results) {
+    using boost::property_tree::ptree;
+    using boost::property_tree::json_parser::write_json;
+    auto summary = [](const Distribution &distribution) {
+        ptree pt;
+        pt.put("mean", distribution.mean());
+        pt.put("p10", distribution.percentile(0.1));
+        pt.put("p50", distribution.percentile(0.5));
+        pt.put("p90", distribution.percentile(0.9));
+        pt.put("p99", distribution.percentile(0.99));
+        pt.put("max", distribution.percentile(1.0));
+        return pt;
+    };
+
+    ptree pt;
+    ptree entries;
+    for (size_t i = 0; i < shooters.size(); ++i) {
+        const SimulationStats &stats = results[i];
+        ptree entry;
+        entry.put("reaction_time_ms", shooters[i].reactionTime);
+        entry.put("accuracy", shooters[i].accuracy);
+        entry.put("games", stats.roundsCleared.size());
+        entry.add_child("rounds_cleared", summary(stats.roundsCleared));
+        entry.add_child("score", summary(stats.score));
+        entry.add_child("shots_per_kill", summary(stats.shotsPerKill));
+        ptree histogram;
+        stats.roundsCleared.forEachBucket([&histogram](double rounds, uint64_t games) {
+            ptree bucket;
+            bucket.put("rounds", rounds);
+            bucket.put("games", games);
+            histogram.push_back(std::make_pair("", bucket));
+        });
+        entry.add_child("rounds_cleared_histogram", histogram);
+        entries.push_back(std::make_pair("", entry));
+    }
+    pt.add_child("shooters", entries);
+    write_json(os, pt);
+}
+
+void printSummary(const std::string &name, const Distribution &distribution) {
+    std::cout << "  " << name << ": mean " << distribution.mean() << ", p10 " << distribution.percentile(0.1)
+              << ", p50 " << distribution.percentile(0.5) << ", p90 " << distribution.percentile(0.9)
+              << ", max " << distribution.percentile(1.0) << std::endl;
+}
+
+int main(int argc, char* argv []) {
+    std::string outPath;
+    long games = 100000;
+    int maxRounds = 99;
+    uint32_t seed = 1;
+    bool doubleDucks = false;
+    unsigned int threads = workerCount();
+    std::vector<ShooterProfile> shooters;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--games" && hasValue)
+                games = std::max(1L, std::stol(argv[++i]));
+            else if (arg == "--shooter" && hasValue)
+                shooters.push_back(parseShooter(argv[++i]));
+            else if (arg == "--max-rounds" && hasValue)
+                maxRounds = std::max(1, std::stoi(argv[++i]));
+            else if (arg == "--seed" && hasValue)
+                seed = static_cast<uint32_t>(std::stoul(argv[++i]));
+            else if (arg == "--threads" && hasValue)
+                threads = static_cast<unsigned int>(std::max(1, std::stoi(argv[++i])));
+            else if (arg == "--double")
+                doubleDucks = true;
+            else if (arg == "--out" && hasValue)
+                outPath = argv[++i];
+            else {
+                std::cout << "Usage: " << argv[0] << " [--games N] [--shooter REACTION_MS:ACCURACY]..."
+                          << " [--max-rounds N] [--seed N] [--threads N] [--double] [--out FILE]" << std::endl;
+                return 1;
+            }
+        }
+    }
+    catch (const std::logic_error& e) {
+        std::cout << "Invalid argument value: " << e.what() << std::endl;
+        return 1;
+    }
+    if (shooters.empty()) {
+        Session defaults;
+        shooters.push_back({defaults.reactionTime, defaults.accuracy});
+    }
+
+    // Only the sizes and pixels of the textures are needed, so they are loaded without a renderer
+    if (SDL_Init(SDL_INIT_TIMER) != 0) {
+        logSDLError(std::cout, "SDL_Init");
+        return 1;
+    }
+    Textures textures = loadTexturesRemake(nullptr);
+    if (!validateTextures(&textures, false)) {
+        cleanup_textures(&textures);
+        SDL_Quit();
+        return 1;
+    }
+    Drawer drawer(textures.background, nullptr, WORLD_WIDTH, WORLD_HEIGHT);
+    Player_Stats start = doubleDucks ? Level::doubleDuckGame() : Level::singleDuckGame();
+
+    std::vector<SimulationStats> results;
+    for (size_t shooterIndex = 0; shooterIndex < shooters.size(); ++shooterIndex) {
+        const ShooterProfile &profile = shooters[shooterIndex];
+        size_t batches = (games + GAMES_PER_BATCH - 1) / GAMES_PER_BATCH;
+        std::vector<SimulationStats> batchStats(batches);
+        auto begin = std::chrono::steady_clock::now();
+
+        // Every batch seeds its own generators, so threads share nothing but the textures they read
+        parallelFor(batches, [&](size_t batch) {
+            Session session;
+            std::seed_seq seeds{seed, static_cast<uint32_t>(shooterIndex), static_cast<uint32_t>(batch)};
+            session.random.seed(seeds);
+            AutoShooter shooter(profile.reactionTime, profile.accuracy, session.random());
+            Player_Stats player_stats = start;
+            SimulatedGame game(&session, &drawer, &player_stats, &textures);
+
+            long first = static_cast<long>(batch) * GAMES_PER_BATCH;
+            long count = std::min<long>(GAMES_PER_BATCH, games - first);
+            for (long i = 0; i < count; ++i)
+                batchStats[batch].add(game.play(start, &shooter, maxRounds));
+        }, threads);
+
+        SimulationStats stats;
+        for (auto &batch : batchStats)
+            stats.merge(batch);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+        std::cout << "Shooter " << profile.reactionTime << " ms, " << profile.accuracy * 100.0 << "% accurate: "
+                  << games << " games in " << seconds << " s" << std::endl;
+        printSummary("Rounds cleared", stats.roundsCleared);
+        printSummary("Score", stats.score);
+        printSummary("Shots per kill", stats.shotsPerKill);
+        results.push_back(std::move(stats));
+    }
+
+    if (!outPath.empty()) {
+        std::ofstream out(outPath, std::ios::trunc);
+        writeResults(out, shooters, results);
+    }
+
+    cleanup_textures(&textures);
+    IMG_Quit();
+    SDL_Quit();
+    return 0;
+}
@@ -0,0 +1,165 @@
+#ifndef DUCKHUNT_SOAK_HPP
+#define DUCKHUNT_SOAK_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <ostream>
+#include <vector>
+#include "SDL2/SDL.h"
+#include "allocations.hpp"
+#include "frame_timer.hpp"
+#include "texture_count.hpp"
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+/// The memory of the process that is in RAM, in MB, or 0 where it cannot be read.
+inline double residentMegabytes() {
+#ifdef __linux__
+    // Read with stdio rather than a stream, so a sample is not counted as one of the game's allocations
+    FILE* file = std::fopen("/proc/self/statm", "r");
+    if (file == nullptr)
+        return 0.0;
+    long size = 0, resident = 0;
+    int read = std::fscanf(file, "%ld %ld", &size, &resident);
+    std::fclose(file);
+    return read == 2 ? static_cast<double>(resident) * sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0) : 0.0;
+#else
+    return 0.0;
+#endif
+}
+
+/// The measurements a soak test watches for growth.
+enum SoakMetric {
+    SOAK_RSS,
+    SOAK_TEXTURES,
+    SOAK_ALLOCATIONS,
+    SOAK_FRAME_AVG,
+    SOAK_FRAME_P99,
+    SOAK_METRIC_COUNT
+};
+
+struct SoakMetricInfo {
+    const char* name;
+    const char* unit;
+    /// The smallest rise over a run that counts as growth, so noise in small values is not taken for a trend.
+    double noiseFloor;
+};
+
+const std::array<SoakMetricInfo, SOAK_METRIC_COUNT> soakMetrics = {{
+    {"rss", " MB", 1.0},
+    {"live textures", "", 1.0},
+    {"live allocations", "", 100.0},
+    {"frame avg", " ms", 0.25},
+    {"frame p99", " ms", 0.5}
+}};
+
+/// Samples the game's memory, textures, allocations and frame times at intervals through a long run, then judges
+/// whether any of them trended upwards, as a leak or a slowdown would.
+/// Samples taken in the first tenth of the run are left out of the trend, while caches fill and the game warms up.
+class SoakMonitor {
+private:
+    struct Sample {
+        double seconds;
+        int games;
+        std::array<double, SOAK_METRIC_COUNT> values;
+    };
+
+    double duration;
+    double interval;
+    double threshold;
+    Uint64 start = 0;
+    double nextSample = 0.0;
+    std::vector<Sample> samples;
+
+public:
+    /// \param duration How long to run for in seconds.
+    /// \param interval The time between samples in seconds.
+    /// \param threshold How much a metric may grow over the run before the test fails, as a fraction of its value.
+    SoakMonitor(double duration, double interval, double threshold) {
+        this->duration = duration;
+        this->interval = std::max(1.0, interval);
+        this->threshold = threshold;
+        // Room for every sample, so sampling does not allocate in the middle of a frame
+        samples.reserve(static_cast<size_t>(duration / this->interval) + 2);
+    }
+
+    /// Called at the end of every frame, takes a sample when one is due.
+    /// \param timer The frame times of the game.
+    /// \param gamesPlayed The number of games finished so far.
+    /// \param os The stream to write samples to.
+    /// \return true once the test has run for its duration.
+    bool frame(const FrameTimer &timer, int gamesPlayed, std::ostream &os) {
+        Uint64 now = SDL_GetPerformanceCounter();
+        if (start == 0)
+            start = now;
+        double seconds = (now - start) / (double)SDL_GetPerformanceFrequency();
+        if (seconds < nextSample)
+            return false;
+        nextSample += interval;
+
+        Sample sample{seconds, gamesPlayed, {}};
+        sample.values[SOAK_RSS] = residentMegabytes();
+        sample.values[SOAK_TEXTURES] = liveTextureCount.load();
+        sample.values[SOAK_ALLOCATIONS] = static_cast<double>(liveAllocations());
+        sample.values[SOAK_FRAME_AVG] = timer.summary(PHASE_COUNT).avg;
+        sample.values[SOAK_FRAME_P99] = timer.summary(PHASE_COUNT).p99;
+        samples.push_back(sample);
+
+        os << "Soak " << static_cast<int>(seconds) << " s, " << gamesPlayed << " games:";
+        for (int metric = 0; metric < SOAK_METRIC_COUNT; ++metric)
+            os << (metric == 0 ? " " : ", ") << soakMetrics[metric].name << ' ' << sample.values[metric]
+               << soakMetrics[metric].unit;
+        os << std::endl;
+        return seconds >= duration;
+    }
+
+    /// Fits a line to each metric's samples after the warm up and reports how much it rose over the run.
+    /// \return false if a metric rose by more than the threshold.
+    bool judge(std::ostream &os) const {
+        double warmUp = std::max(interval, duration / 10.0);
+        auto first = std::find_if(samples.begin(), samples.end(), [warmUp](const Sample &sample) {
+            return sample.seconds >= warmUp;
+        });
+        if (samples.end() - first < 3) {
+            os << "Soak test too short to judge drift, " << samples.size() << " samples" << std::endl;
+            return true;
+        }
+
+        bool passed = true;
+        for (int metric = 0; metric < SOAK_METRIC_COUNT; ++metric) {
+            const SoakMetricInfo &info = soakMetrics[metric];
+            if (std::all_of(first, samples.end(), [metric](const Sample &sample) { return sample.values[metric] == 0.0; })) {
+                os << "Soak " << info.name << ": not measured" << std::endl;
+                continue;
+            }
+
+            // Least squares fit of value against time
+            double n = static_cast<double>(samples.end() - first);
+            double meanT = 0.0, meanV = 0.0;
+            for (auto sample = first; sample != samples.end(); ++sample) {
+                meanT += sample->seconds / n;
+                meanV += sample->values[metric] / n;
+            }
+            double covariance = 0.0, variance = 0.0;
+            for (auto sample = first; sample != samples.end(); ++sample) {
+                covariance += (sample->seconds - meanT) * (sample->values[metric] - meanV);
+                variance += (sample->seconds - meanT) * (sample->seconds - meanT);
+            }
+            double slope = variance > 0.0 ? covariance / variance : 0.0;
+            double startValue = meanV - slope * (meanT - first->seconds);
+            double rise = slope * (samples.back().seconds - first->seconds);
+            double limit = std::max(info.noiseFloor, threshold * std::abs(startValue));
+
+            bool drifted = rise > limit;
+            passed = passed && !drifted;
+            os << "Soak " << info.name << ": " << startValue << info.unit << " rising by " << rise << info.unit
+               << " over the run, limit " << limit << info.unit << (drifted ? ", FAILED" : "") << std::endl;
+        }
+        return passed;
+    }
+};
+
+#endif //DUCKHUNT_SOAK_HPP
@@ -0,0 +1,111 @@
+#ifndef DUCKHUNT_SPATIAL_GRID_HPP
+#define DUCKHUNT_SPATIAL_GRID_HPP
+
+#include <algorithm>
+#include <vector>
+#include "SDL2/SDL.h"
+
+/// A uniform grid over an area of the world, listing each object in the cell holding the top left corner of its
+/// bounds, so the objects under a point are found without testing every object.
+/// Each object is listed once, so rebuilding is a counting sort without branches on the object's size, cheap enough to
+/// do every time the objects move. A query looks in the cells up and to the left of the point as far as the largest
+/// object reaches. Objects and points outside the area are treated as being in the nearest edge cell. The grid keeps
+/// its memory between rebuilds, so rebuilding it for the same number of objects does not allocate.
+class SpatialGrid {
+private:
+    int left;
+    int top;
+    /// The log2 of the width and height of a cell, so finding a cell is a shift.
+    int cellShift;
+    int columns;
+    int rows;
+    /// How many cells to the left and up from a point objects in the last rebuild can reach it from.
+    int reach;
+    /// Where each cell's objects start in ::items, with one more entry for the end of the last cell.
+    std::vector<int> cellStart;
+    /// Where the next object of each cell goes while rebuilding.
+    std::vector<int> cursor;
+    std::vector<int> items;
+    /// The cell of each object in the last rebuild, or -1 for objects left out.
+    std::vector<int> cells;
+
+public:
+    /// \param area The area of the world to divide into cells.
+    /// \param cellSize The width and height of a cell, a power of two.
+    SpatialGrid(SDL_Rect area, int cellSize) {
+        left = area.x;
+        top = area.y;
+        cellShift = 0;
+        while ((2 << cellShift) <= cellSize)
+            cellShift++;
+        columns = std::max(1, (area.w + (1 << cellShift) - 1) >> cellShift);
+        rows = std::max(1, (area.h + (1 << cellShift) - 1) >> cellShift);
+        reach = 0;
+        cellStart.assign(columns * rows + 1, 0);
+        cursor.assign(columns * rows, 0);
+    }
+
+    /// Makes room for a number of objects, so rebuilding does not allocate.
+    void reserve(size_t objects) {
+        items.reserve(objects);
+        cells.reserve(objects);
+    }
+
+    /// Lists objects by the cells their top left corners are in.
+    /// \param count The number of objects.
+    /// \param bounds Called as bounds(index, SDL_Rect* rect) to fill in an object's bounds, returning false to leave
+    /// the object out.
+    template<typename Bounds>
+    void rebuild(size_t count, Bounds bounds) {
+        // Count the objects in each cell, then give each cell its range of items
+        std::fill(cellStart.begin(), cellStart.end(), 0);
+        cells.resize(count);
+        int largest = 1;
+        SDL_Rect rect;
+        for (size_t i = 0; i < count; ++i) {
+            if (!bounds(i, &rect)) {
+                cells[i] = -1;
+                continue;
+            }
+            int cell = row(rect.y) * columns + column(rect.x);
+            cells[i] = cell;
+            cellStart[cell + 1]++;
+            largest = std::max(largest, std::max(rect.w, rect.h));
+        }
+        for (size_t cell = 1; cell < cellStart.size(); ++cell)
+            cellStart[cell] += cellStart[cell - 1];
+        items.resize(cellStart.back());
+        std::copy(cellStart.begin(), cellStart.end() - 1, cursor.begin());
+        // An object reaches at most this many cells past the one its corner is in
+        reach = (largest + (1 << cellShift) - 2) >> cellShift;
+
+        // Objects are listed in index order in each cell
+        for (size_t i = 0; i < count; ++i)
+            if (cells[i] >= 0)
+                items[cursor[cells[i]]++] = static_cast<int>(i);
+    }
+
+    /// Calls visit(index) with the index of every object whose bounds may hold a point, along with some that do not.
+    /// Each cell's objects are visited in index order, but the cells are not.
+    template<typename Visit>
+    void forEachNear(int x, int y, Visit visit) const {
+        int column1 = column(x), row1 = row(y);
+        for (int row = std::max(0, row1 - reach); row <= row1; ++row)
+            for (int column = std::max(0, column1 - reach); column <= column1; ++column) {
+                int cell = row * columns + column;
+                for (int i = cellStart[cell]; i < cellStart[cell + 1]; ++i)
+                    visit(items[i]);
+            }
+    }
+
+private:
+    int column(int x) const {
+        return std::min(columns - 1, std::max(0, x - left) >> cellShift);
+    }
+
+    int row(int y) const {
+        return std::min(rows - 1, std::max(0, y - top) >> cellShift);
+    }
+};
+
+#endif //DUCKHUNT_SPATIAL_GRID_HPP
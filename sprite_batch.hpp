@@ -0,0 +1,161 @@
+#ifndef DUCKHUNT_SPRITE_BATCH_HPP
+#define DUCKHUNT_SPRITE_BATCH_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "SDL2/SDL.h"
+
+/// The layers of a frame, drawn in this order.
+enum DrawLayer {
+    LAYER_BACKGROUND,
+    LAYER_FOREGROUND,
+    LAYER_UI
+};
+
+/// Collects the sprites of a frame and submits them in as few draw calls as possible.
+/// Sprites are ordered by layer and then by submission order, and consecutive sprites sharing a texture are drawn
+/// together. With every texture packed onto one atlas page this is a single draw call per frame.
+class SpriteBatch {
+private:
+    struct Sprite {
+        SDL_Texture* texture;
+        int layer;
+        SDL_Rect src;
+        SDL_Rect dst;
+        double angle;
+        SDL_Point center;
+        SDL_RendererFlip flip;
+    };
+
+    std::vector<Sprite> sprites;
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+    int drawCalls = 0;
+
+public:
+    /// The layer newly added sprites are drawn on.
+    int layer = LAYER_BACKGROUND;
+
+    /// Queues a sprite to be drawn by the next ::flush(SDL_Renderer* renderer).
+    /// \param texture The source texture.
+    /// \param src The region of the texture to draw, or nullptr for all of it.
+    /// \param dst The rect to draw to, in window pixels.
+    /// \param angle The clockwise rotation in degrees.
+    /// \param center The point to rotate around relative to dst, or nullptr for its centre.
+    /// \param flip How to flip the sprite.
+    void add(SDL_Texture* texture, const SDL_Rect* src, const SDL_Rect &dst, double angle, const SDL_Point* center, SDL_RendererFlip flip) {
+        if (texture == nullptr)
+            return;
+        Sprite sprite{texture, layer, {0, 0, 0, 0}, dst, angle, {dst.w / 2, dst.h / 2}, flip};
+        if (src != nullptr)
+            sprite.src = *src;
+        else
+            SDL_QueryTexture(texture, nullptr, nullptr, &sprite.src.w, &sprite.src.h);
+        if (center != nullptr)
+            sprite.center = *center;
+        sprites.push_back(sprite);
+    }
+
+    /// Discards all queued sprites.
+    void clear() {
+        sprites.clear();
+    }
+
+    /// Draws all queued sprites and empties the queue.
+    /// \param renderer The renderer to draw with.
+    void flush(SDL_Renderer* renderer) {
+        sortByLayer();
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+        vertices.clear();
+        for (auto &sprite : sprites)
+            appendQuad(sprite);
+
+        size_t first = 0;
+        while (first < sprites.size()) {
+            size_t last = first + 1;
+            while (last < sprites.size() && sprites[last].texture == sprites[first].texture)
+                last++;
+
+            auto count = static_cast<int>(last - first);
+            growIndices(count);
+            SDL_RenderGeometry(renderer, sprites[first].texture, &vertices[first * 4], count * 4, indices.data(), count * 6);
+            drawCalls++;
+            first = last;
+        }
+#else
+        for (auto &sprite : sprites) {
+            SDL_RenderCopyEx(renderer, sprite.texture, &sprite.src, &sprite.dst, sprite.angle, &sprite.center, sprite.flip);
+            drawCalls++;
+        }
+#endif
+        sprites.clear();
+    }
+
+    /// The number of draw calls made since the last call to this, for diagnostics.
+    int takeDrawCalls() {
+        int calls = drawCalls;
+        drawCalls = 0;
+        return calls;
+    }
+
+private:
+    /// Sorts the sprites by layer, keeping their order within a layer.
+    /// An insertion sort, as std::stable_sort allocates a buffer each time. Sprites mostly arrive in layer order, so
+    /// this is usually a single pass.
+    void sortByLayer() {
+        auto byLayer = [](int layer, const Sprite &sprite) {
+            return layer < sprite.layer;
+        };
+        for (auto i = sprites.begin() + (sprites.empty() ? 0 : 1); i < sprites.end(); ++i)
+            if (i->layer < (i - 1)->layer)
+                std::rotate(std::upper_bound(sprites.begin(), i, i->layer, byLayer), i, i + 1);
+    }
+
+    /// Appends the four corners of a sprite, top left first and clockwise.
+    void appendQuad(const Sprite &sprite) {
+        int textureWidth, textureHeight;
+        SDL_QueryTexture(sprite.texture, nullptr, nullptr, &textureWidth, &textureHeight);
+        float u0 = static_cast<float>(sprite.src.x) / textureWidth;
+        float v0 = static_cast<float>(sprite.src.y) / textureHeight;
+        float u1 = static_cast<float>(sprite.src.x + sprite.src.w) / textureWidth;
+        float v1 = static_cast<float>(sprite.src.y + sprite.src.h) / textureHeight;
+        if (sprite.flip & SDL_FLIP_HORIZONTAL)
+            std::swap(u0, u1);
+        if (sprite.flip & SDL_FLIP_VERTICAL)
+            std::swap(v0, v1);
+
+        const float w = static_cast<float>(sprite.dst.w);
+        const float h = static_cast<float>(sprite.dst.h);
+        const SDL_FPoint corners[4] = {{0, 0}, {w, 0}, {w, h}, {0, h}};
+        const SDL_FPoint uvs[4] = {{u0, v0}, {u1, v0}, {u1, v1}, {u0, v1}};
+        const SDL_Color white = {255, 255, 255, 255};
+
+        double c = 1.0, s = 0.0;
+        if (sprite.angle != 0.0) {
+            double radians = sprite.angle * std::acos(-1) / 180.0;
+            c = std::cos(radians);
+            s = std::sin(radians);
+        }
+        for (int i = 0; i < 4; ++i) {
+            double x = corners[i].x - sprite.center.x;
+            double y = corners[i].y - sprite.center.y;
+            SDL_FPoint position = {
+                static_cast<float>(sprite.dst.x + sprite.center.x + x * c - y * s),
+                static_cast<float>(sprite.dst.y + sprite.center.y + x * s + y * c)
+            };
+            vertices.push_back({position, white, uvs[i]});
+        }
+    }
+
+    /// Makes sure the shared index list covers at least count quads.
+    void growIndices(int count) {
+        for (auto quad = static_cast<int>(indices.size() / 6); quad < count; ++quad) {
+            int v = quad * 4;
+            indices.insert(indices.end(), {v, v + 1, v + 2, v + 2, v + 3, v});
+        }
+    }
+};
+
+#endif //DUCKHUNT_SPRITE_BATCH_HPP
@@ -0,0 +1,35 @@
+#ifndef DUCKHUNT_TEXTURE_COUNT_HPP
+#define DUCKHUNT_TEXTURE_COUNT_HPP
+
+#include <atomic>
+#include "SDL2/SDL.h"
+
+// SDL cannot say how many textures a renderer holds, so the game creates and destroys its textures through these
+// functions, which keep count. A count that keeps growing while the game runs is a texture leak.
+
+/// The number of textures created and not yet destroyed.
+inline std::atomic<int> liveTextureCount(0);
+
+inline SDL_Texture* createTexture(SDL_Renderer* renderer, Uint32 format, int access, int w, int h) {
+    SDL_Texture* texture = SDL_CreateTexture(renderer, format, access, w, h);
+    if (texture != nullptr)
+        liveTextureCount++;
+    return texture;
+}
+
+inline SDL_Texture* createTextureFromSurface(SDL_Renderer* renderer, SDL_Surface* surface) {
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+    if (texture != nullptr)
+        liveTextureCount++;
+    return texture;
+}
+
+/// Destroys a texture made by createTexture() or createTextureFromSurface(), nothing for nullptr.
+inline void destroyTexture(SDL_Texture* texture) {
+    if (texture == nullptr)
+        return;
+    SDL_DestroyTexture(texture);
+    liveTextureCount--;
+}
+
+#endif //DUCKHUNT_TEXTURE_COUNT_HPP
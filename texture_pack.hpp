@@ -0,0 +1,202 @@
+#ifndef DUCKHUNT_TEXTURE_PACK_HPP
+#define DUCKHUNT_TEXTURE_PACK_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <vector>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// A texture pack holds the textures of both sets already decoded to ARGB8888, so they can be used straight from the
+// file. It is written by the duckhunt_packer tool. All values are in native byte order.
+//   header:  PackHeader
+//   index:   one PackEntry per texture
+//   pixels:  the rows of each texture, each texture starting on a 16 byte boundary
+
+const char* const texturePackFile = "textures/textures.pack";
+const char texturePackMagic[4] = {'D', 'H', 'P', 'K'};
+const uint32_t texturePackVersion = 1;
+const size_t texturePackAlignment = 16;
+
+struct PackHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t padding;
+};
+
+struct PackEntry {
+    /// The PNG the texture was decoded from.
+    char source[64];
+    uint32_t width;
+    uint32_t height;
+    uint32_t pitch;
+    /// The number of frames on the strip.
+    uint32_t frames;
+    /// Where the pixels start, from the start of the file.
+    uint64_t offset;
+    /// The size and modification time of the PNG when it was packed, to tell if the pack is out of date.
+    uint64_t sourceSize;
+    int64_t sourceModified;
+};
+
+/// Reads the size and modification time of a file.
+/// \return false if the file could not be found.
+inline bool sourceStamp(const char* path, uint64_t* size, int64_t* modified) {
+    std::error_code error;
+    auto fileSize = std::filesystem::file_size(path, error);
+    if (error)
+        return false;
+    auto fileTime = std::filesystem::last_write_time(path, error);
+    if (error)
+        return false;
+    *size = fileSize;
+    *modified = static_cast<int64_t>(fileTime.time_since_epoch().count());
+    return true;
+}
+
+/// A whole file mapped read-only into memory, or read into memory where mapping is not available.
+class MappedFile {
+private:
+    const uint8_t* bytes = nullptr;
+    size_t length = 0;
+    std::vector<uint8_t> buffer;
+
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        close();
+    }
+
+    /// \return false if the file could not be opened.
+    bool open(const std::string &filename) {
+        close();
+#ifndef _WIN32
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat info{};
+        if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+            ::close(fd);
+            return false;
+        }
+        void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED)
+            return false;
+        bytes = static_cast<const uint8_t*>(mapped);
+        length = static_cast<size_t>(info.st_size);
+#else
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        if (!file.good())
+            return false;
+        buffer.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        if (buffer.empty() || !file.read(reinterpret_cast<char*>(buffer.data()), buffer.size()))
+            return false;
+        bytes = buffer.data();
+        length = buffer.size();
+#endif
+        return true;
+    }
+
+    void close() {
+#ifndef _WIN32
+        if (bytes != nullptr)
+            munmap(const_cast<uint8_t*>(bytes), length);
+#endif
+        buffer.clear();
+        bytes = nullptr;
+        length = 0;
+    }
+
+    const uint8_t* data() const {
+        return bytes;
+    }
+
+    size_t size() const {
+        return length;
+    }
+};
+
+/// A texture pack mapped into memory. The pixels it returns are only valid while it is open.
+class TexturePack {
+private:
+    MappedFile file;
+    const PackHeader* header = nullptr;
+    const PackEntry* entries = nullptr;
+
+public:
+    /// Maps a pack and checks that its index and pixels are within the file.
+    /// \return false if the file is missing or not a pack this version can read.
+    bool open(const std::string &filename) {
+        header = nullptr;
+        entries = nullptr;
+        if (!file.open(filename))
+            return false;
+        if (file.size() < sizeof(PackHeader))
+            return false;
+        auto candidate = reinterpret_cast<const PackHeader*>(file.data());
+        if (std::memcmp(candidate->magic, texturePackMagic, sizeof(texturePackMagic)) != 0 ||
+            candidate->version != texturePackVersion ||
+            file.size() < sizeof(PackHeader) + candidate->entryCount * sizeof(PackEntry))
+            return false;
+
+        auto index = reinterpret_cast<const PackEntry*>(file.data() + sizeof(PackHeader));
+        for (uint32_t i = 0; i < candidate->entryCount; ++i) {
+            const PackEntry &entry = index[i];
+            if (entry.source[sizeof(entry.source) - 1] != '\0' || entry.pitch < entry.width * 4 ||
+                entry.offset > file.size() || uint64_t(entry.pitch) * entry.height > file.size() - entry.offset)
+                return false;
+        }
+        header = candidate;
+        entries = index;
+        return true;
+    }
+
+    bool isOpen() const {
+        return header != nullptr;
+    }
+
+    /// Finds the texture decoded from a PNG.
+    /// \param source The path of the PNG.
+    /// \return The texture's entry, or nullptr if it is not in the pack.
+    const PackEntry* find(const char* source) const {
+        if (header == nullptr)
+            return nullptr;
+        for (uint32_t i = 0; i < header->entryCount; ++i)
+            if (std::strcmp(entries[i].source, source) == 0)
+                return &entries[i];
+        return nullptr;
+    }
+
+    /// Whether a texture was packed from its PNG as it is now, with the given number of frames.
+    /// A missing PNG counts as current, so a pack can be shipped without them.
+    static bool isCurrent(const PackEntry &entry, int frames) {
+        uint64_t size;
+        int64_t modified;
+        if (entry.frames != static_cast<uint32_t>(frames))
+            return false;
+        if (!sourceStamp(entry.source, &size, &modified))
+            return true;
+        return size == entry.sourceSize && modified == entry.sourceModified;
+    }
+
+    /// The ARGB8888 pixels of a texture, rows entry.pitch bytes apart.
+    const void* pixels(const PackEntry &entry) const {
+        return file.data() + entry.offset;
+    }
+};
+
+#endif //DUCKHUNT_TEXTURE_PACK_HPP
@@ -0,0 +1,101 @@
+#ifndef DUCKHUNT_TEXTURE_SETS_HPP
+#define DUCKHUNT_TEXTURE_SETS_HPP
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include "SDL2/SDL.h"
+#include "textures.hpp"
+#include "texture_count.hpp"
+
+/// Switches the game's Textures between the original and remake sets while it runs.
+/// The new set is decoded on a background thread, then swapped in between frames by replacing the contents of the
+/// same Textures, so every scene, drawer and animation pointing into it draws the new set from then on.
+class TextureSets {
+private:
+    Textures* textures;
+    bool remake;
+    std::thread loader;
+    std::unique_ptr<DecodedTextures> decoded;
+    std::atomic<bool> decodedReady{false};
+    /// Bumped every time the textures are swapped.
+    int generation = 0;
+
+public:
+    /// \param textures The loaded textures, which are swapped in place.
+    /// \param remake Which set textures holds.
+    TextureSets(Textures* textures, bool remake) {
+        this->textures = textures;
+        this->remake = remake;
+    }
+
+    TextureSets(const TextureSets&) = delete;
+    TextureSets& operator=(const TextureSets&) = delete;
+
+    ~TextureSets() {
+        if (loader.joinable())
+            loader.join();
+    }
+
+    /// Which set is shown.
+    bool isRemake() const {
+        return remake;
+    }
+
+    /// Which set will be shown once any set being loaded has been swapped in.
+    bool willBeRemake() const {
+        return decoded != nullptr ? decoded->remake : remake;
+    }
+
+    int getGeneration() const {
+        return generation;
+    }
+
+    /// Starts loading a set in the background, unless it is already shown or a set is already being loaded.
+    /// \param remake true for the remake's textures, false for the original game's textures.
+    void request(bool remake) {
+        if (decoded != nullptr || remake == this->remake)
+            return;
+        decoded = std::make_unique<DecodedTextures>();
+        decodedReady = false;
+        DecodedTextures* target = decoded.get();
+        loader = std::thread([this, target, remake]() {
+            decodeTextures(remake, target);
+            decodedReady = true;
+        });
+    }
+
+    /// Starts loading whichever set is not shown.
+    void toggle() {
+        request(!remake);
+    }
+
+    /// Swaps in a set that has finished loading and frees the old one. Call between frames, on the renderer's thread.
+    /// \param renderer The renderer to create the new atlas pages on, or nullptr when running headless.
+    /// \return true if the textures changed, so anything cached from them is out of date.
+    bool apply(SDL_Renderer* renderer) {
+        if (decoded == nullptr || !decodedReady)
+            return false;
+        loader.join();
+        Textures fresh = buildTextures(renderer, *decoded);
+        bool freshRemake = decoded->remake;
+        decoded.reset();
+
+        if (!validateTextures(&fresh, renderer != nullptr)) {
+            std::cout << "Could not load the " << (freshRemake ? "remake" : "original") << " textures, keeping the "
+                      << (remake ? "remake" : "original") << " textures" << std::endl;
+            for (SDL_Texture* page : fresh.pages)
+                destroyTexture(page);
+            return false;
+        }
+        for (SDL_Texture* page : textures->pages)
+            destroyTexture(page);
+        *textures = fresh;
+        remake = freshRemake;
+        generation++;
+        return true;
+    }
+};
+
+#endif //DUCKHUNT_TEXTURE_SETS_HPP
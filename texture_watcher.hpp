@@ -0,0 +1,199 @@
+#ifndef DUCKHUNT_TEXTURE_WATCHER_HPP
+#define DUCKHUNT_TEXTURE_WATCHER_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SDL2/SDL.h"
+#include "textures.hpp"
+#include "texture_sets.hpp"
+#include "texture_count.hpp"
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+/// Reloads textures while the game runs when their PNGs change on disk, for artists working on them.
+/// A background thread watches the texture directories with inotify and decodes changed files. Between frames the
+/// decoded images replace their textures, each on a texture of its own, as the atlas pages cannot change size.
+class TextureWatcher {
+private:
+    const std::array<const char*, 2> directories = {"textures", "textures/original"};
+
+    Textures* textures;
+    TextureSets* textureSets;
+    std::thread watcher;
+    std::atomic<bool> stopping{false};
+    int inotify = -1;
+    std::array<int, 2> watches = {-1, -1};
+
+    /// Images decoded by the watcher thread, by path, waiting for ::apply(SDL_Renderer* renderer).
+    std::mutex mutex;
+    std::map<std::string, SDL_Surface*> changed;
+
+    /// The textures made for reloaded images, by index in textureFiles, and the texture set generation they belong to.
+    std::map<size_t, SDL_Texture*> reloaded;
+    int generation = 0;
+
+public:
+    /// \param textures The textures to update.
+    /// \param textureSets Which texture set is shown, so that only its files are reloaded.
+    TextureWatcher(Textures* textures, TextureSets* textureSets) {
+        this->textures = textures;
+        this->textureSets = textureSets;
+    }
+
+    TextureWatcher(const TextureWatcher&) = delete;
+    TextureWatcher& operator=(const TextureWatcher&) = delete;
+
+    ~TextureWatcher() {
+        stopping = true;
+        if (watcher.joinable())
+            watcher.join();
+#ifdef __linux__
+        if (inotify >= 0)
+            close(inotify);
+#endif
+        for (auto &entry : changed)
+            SDL_FreeSurface(entry.second);
+    }
+
+    /// Starts watching the texture directories.
+    /// \return false if they cannot be watched.
+    bool start() {
+#ifdef __linux__
+        inotify = inotify_init1(IN_NONBLOCK);
+        if (inotify < 0) {
+            std::cout << "Could not start watching textures: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        for (size_t i = 0; i < directories.size(); ++i) {
+            watches[i] = inotify_add_watch(inotify, directories[i], IN_CLOSE_WRITE | IN_MOVED_TO);
+            if (watches[i] < 0)
+                std::cout << "Could not watch " << directories[i] << ": " << std::strerror(errno) << std::endl;
+        }
+        watcher = std::thread([this]() { watch(); });
+        return true;
+#else
+        std::cout << "Watching textures is only supported on Linux" << std::endl;
+        return false;
+#endif
+    }
+
+    /// Replaces the textures of images that changed since the last call. Call between frames, on the renderer's thread.
+    /// \param renderer The renderer to create the textures on, or nullptr when running headless.
+    /// \return true if the textures changed, so anything cached from them is out of date.
+    bool apply(SDL_Renderer* renderer) {
+        std::map<std::string, SDL_Surface*> images;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (changed.empty())
+                return false;
+            images.swap(changed);
+        }
+
+        // A texture set swap destroyed the pages, including the ones made here
+        if (generation != textureSets->getGeneration()) {
+            reloaded.clear();
+            generation = textureSets->getGeneration();
+        }
+
+        bool updated = false;
+        for (size_t i = 0; i < textureFiles.size(); ++i) {
+            const TextureFile &file = textureFiles[i];
+            auto image = images.find(textureSets->isRemake() ? file.remake : file.original);
+            if (image != images.end() && replace(renderer, i, image->second)) {
+                std::cout << "Reloaded " << image->first << std::endl;
+                updated = true;
+            }
+        }
+        for (auto &image : images)
+            SDL_FreeSurface(image.second);
+
+        if (updated) {
+            textures->font_green = BitmapFont(textures->ui_numbers_green);
+            textures->font_white = BitmapFont(textures->ui_numbers_white);
+        }
+        return updated;
+    }
+
+private:
+    /// Points a texture's region at a new image.
+    bool replace(SDL_Renderer* renderer, size_t index, SDL_Surface* image) {
+        TextureRegion &region = textures->*textureFiles[index].region;
+        SDL_Texture* texture = nullptr;
+        if (renderer != nullptr) {
+            texture = createTextureFromSurface(renderer, image);
+            if (texture == nullptr) {
+                logSDLError(std::cout, "CreateTextureFromSurface");
+                return false;
+            }
+            SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+            textures->pages.push_back(texture);
+        }
+
+        // Free the texture from an earlier reload, the image's space on its atlas page is left unused
+        auto previous = reloaded.find(index);
+        if (previous != reloaded.end()) {
+            auto &pages = textures->pages;
+            pages.erase(std::remove(pages.begin(), pages.end(), previous->second), pages.end());
+            destroyTexture(previous->second);
+            reloaded.erase(previous);
+        }
+        if (texture != nullptr)
+            reloaded[index] = texture;
+        region = {texture, {0, 0, image->w, image->h}, region.mask};
+        if (region.mask >= 0)
+            textures->masks[region.mask] = AlphaMask(image);
+        return true;
+    }
+
+#ifdef __linux__
+    void watch() {
+        alignas(inotify_event) char buffer[4096];
+        while (!stopping) {
+            pollfd fd = {inotify, POLLIN, 0};
+            if (poll(&fd, 1, 200) <= 0)
+                continue;
+
+            // Decode each file once however many events it caused
+            std::vector<std::string> paths;
+            ssize_t length;
+            while ((length = read(inotify, buffer, sizeof(buffer))) > 0) {
+                for (char* next = buffer; next < buffer + length;) {
+                    auto event = reinterpret_cast<inotify_event*>(next);
+                    next += sizeof(inotify_event) + event->len;
+                    std::string name = event->len > 0 ? event->name : "";
+                    if (name.size() < 4 || name.compare(name.size() - 4, 4, ".png") != 0)
+                        continue;
+                    auto watch = std::find(watches.begin(), watches.end(), event->wd);
+                    if (watch == watches.end())
+                        continue;
+                    std::string path = std::string(directories[watch - watches.begin()]) + "/" + name;
+                    if (std::find(paths.begin(), paths.end(), path) == paths.end())
+                        paths.push_back(path);
+                }
+            }
+
+            for (auto &path : paths) {
+                SDL_Surface* surface = loadSurface(path);
+                if (surface == nullptr)
+                    continue;
+                std::lock_guard<std::mutex> lock(mutex);
+                SDL_FreeSurface(changed[path]);
+                changed[path] = surface;
+            }
+        }
+    }
+#endif
+};
+
+#endif //DUCKHUNT_TEXTURE_WATCHER_HPP
@@ -5,217 +5,309 @@
 #include <SDL2/SDL_image.h>
 #include <array>
 #include <vector>
+#include <sstream>
 #include <algorithm>
 #include "errors.hpp"
+#include "atlas.hpp"
+#include "alpha_mask.hpp"
+#include "font.hpp"
+#include "trace.hpp"
+#include "parallel.hpp"
+#include "texture_pack.hpp"
 
 struct Textures {
-    SDL_Texture* ui_bullet;
-    SDL_Texture* ui_duck_lit;
-    SDL_Texture* ui_duck_white;
-    SDL_Texture* ui_ducks_needed_bar;
-    SDL_Texture* ui_hit;
-    SDL_Texture* ui_message_fly_away;
-    SDL_Texture* ui_message_game_over;
-    SDL_Texture* ui_message_round;
-    SDL_Texture* ui_numbers_green;
-    SDL_Texture* ui_numbers_white;
-    SDL_Texture* ui_score;
-    SDL_Texture* ui_shot;
-    SDL_Texture* ui_round;
-    SDL_Texture* background;
-    SDL_Texture* background_fail;
-    SDL_Texture* dog_failure;
-    SDL_Texture* dog_jumping;
-    SDL_Texture* dog_sniffing;
-    SDL_Texture* dog_success;
-    SDL_Texture* duck_blue_dead;
-    SDL_Texture* duck_blue_diagonal;
-    SDL_Texture* duck_blue_falling;
-    SDL_Texture* duck_blue_horizontal;
-    SDL_Texture* duck_blue_vertical;
-    SDL_Texture* duck_brown_dead;
-    SDL_Texture* duck_brown_diagonal;
-    SDL_Texture* duck_brown_falling;
-    SDL_Texture* duck_brown_horizontal;
-    SDL_Texture* duck_brown_vertical;
-    SDL_Texture* duck_red_dead;
-    SDL_Texture* duck_red_diagonal;
-    SDL_Texture* duck_red_falling;
-    SDL_Texture* duck_red_horizontal;
-    SDL_Texture* duck_red_vertical;
-    SDL_Texture* duck_score;
-    SDL_Texture* foreground;
-    SDL_Texture* main_menu_background;
+    TextureRegion ui_bullet;
+    TextureRegion ui_duck_lit;
+    TextureRegion ui_duck_white;
+    TextureRegion ui_ducks_needed_bar;
+    TextureRegion ui_hit;
+    TextureRegion ui_message_fly_away;
+    TextureRegion ui_message_game_over;
+    TextureRegion ui_message_round;
+    TextureRegion ui_numbers_green;
+    TextureRegion ui_numbers_white;
+    TextureRegion ui_score;
+    TextureRegion ui_shot;
+    TextureRegion ui_round;
+    TextureRegion background;
+    TextureRegion background_fail;
+    TextureRegion dog_failure;
+    TextureRegion dog_jumping;
+    TextureRegion dog_sniffing;
+    TextureRegion dog_success;
+    TextureRegion duck_blue_dead;
+    TextureRegion duck_blue_diagonal;
+    TextureRegion duck_blue_falling;
+    TextureRegion duck_blue_horizontal;
+    TextureRegion duck_blue_vertical;
+    TextureRegion duck_brown_dead;
+    TextureRegion duck_brown_diagonal;
+    TextureRegion duck_brown_falling;
+    TextureRegion duck_brown_horizontal;
+    TextureRegion duck_brown_vertical;
+    TextureRegion duck_red_dead;
+    TextureRegion duck_red_diagonal;
+    TextureRegion duck_red_falling;
+    TextureRegion duck_red_horizontal;
+    TextureRegion duck_red_vertical;
+    TextureRegion duck_score;
+    TextureRegion foreground;
+    TextureRegion main_menu_background;
+    /// The digit fonts of ui_numbers_green and ui_numbers_white.
+    BitmapFont font_green;
+    BitmapFont font_white;
+    /// The atlas pages the regions above are packed onto.
+    std::vector<SDL_Texture*> pages;
+    /// Which pixels of each image are opaque, one mask per entry of textureFiles, for hit testing.
+    std::vector<AlphaMask> masks;
 };
 
+/// A texture the game uses and the files it is loaded from.
+struct TextureFile {
+    TextureRegion Textures::* region;
+    const char* remake;
+    const char* original;
+    /// The number of frames on the strip, 1 for a still image.
+    int frames;
+};
+
+const std::array<TextureFile, 37> textureFiles = {{
+    {&Textures::ui_bullet, "textures/ui_bullet.png", "textures/original/ui_bullet.png", 1},
+    {&Textures::ui_duck_lit, "textures/ui_duck_lit.png", "textures/original/ui_duck_lit.png", 1},
+    {&Textures::ui_duck_white, "textures/ui_duck_white.png", "textures/original/ui_duck_white.png", 1},
+    {&Textures::ui_ducks_needed_bar, "textures/ui_ducks_needed_bar.png", "textures/original/ui_ducks_needed_bar.png", 1},
+    {&Textures::ui_hit, "textures/ui_hit.png", "textures/original/ui_hit.png", 1},
+    {&Textures::ui_message_fly_away, "textures/ui_message_fly_away.png", "textures/ui_message_fly_away.png", 1},
+    {&Textures::ui_message_game_over, "textures/ui_message_game_over.png", "textures/ui_message_game_over.png", 1},
+    {&Textures::ui_message_round, "textures/ui_message_round.png", "textures/ui_message_round.png", 1},
+    {&Textures::ui_numbers_green, "textures/ui_numbers_green.png", "textures/ui_numbers_green.png", 10},
+    {&Textures::ui_numbers_white, "textures/ui_numbers_white.png", "textures/ui_numbers_white.png", 10},
+    {&Textures::ui_score, "textures/ui_score.png", "textures/original/ui_score.png", 1},
+    {&Textures::ui_shot, "textures/ui_shot.png", "textures/original/ui_shot.png", 1},
+    {&Textures::ui_round, "textures/ui_round.png", "textures/ui_round.png", 1},
+    {&Textures::background, "textures/background.png", "textures/original/background.png", 1},
+    {&Textures::background_fail, "textures/background_fail.png", "textures/original/background_fail.png", 1},
+    {&Textures::dog_failure, "textures/dog_failure.png", "textures/original/dog_failure.png", 2},
+    {&Textures::dog_jumping, "textures/dog_jumping.png", "textures/original/dog_jumping.png", 2},
+    {&Textures::dog_sniffing, "textures/dog_sniffing.png", "textures/original/dog_sniffing.png", 6},
+    {&Textures::dog_success, "textures/dog_success.png", "textures/original/dog_success.png", 12},
+    {&Textures::duck_blue_dead, "textures/duck_blue_dead.png", "textures/original/duck_blue_dead.png", 1},
+    {&Textures::duck_blue_diagonal, "textures/duck_blue_diagonal.png", "textures/original/duck_blue_diagonal.png", 3},
+    {&Textures::duck_blue_falling, "textures/duck_blue_falling.png", "textures/original/duck_blue_falling.png", 4},
+    {&Textures::duck_blue_horizontal, "textures/duck_blue_horizontal.png", "textures/original/duck_blue_horizontal.png", 3},
+    {&Textures::duck_blue_vertical, "textures/duck_blue_vertical.png", "textures/original/duck_blue_vertical.png", 3},
+    {&Textures::duck_brown_dead, "textures/duck_brown_dead.png", "textures/original/duck_brown_dead.png", 1},
+    {&Textures::duck_brown_diagonal, "textures/duck_brown_diagonal.png", "textures/original/duck_brown_diagonal.png", 3},
+    {&Textures::duck_brown_falling, "textures/duck_brown_falling.png", "textures/original/duck_brown_falling.png", 4},
+    {&Textures::duck_brown_horizontal, "textures/duck_brown_horizontal.png", "textures/original/duck_brown_horizontal.png", 3},
+    {&Textures::duck_brown_vertical, "textures/duck_brown_vertical.png", "textures/original/duck_brown_vertical.png", 3},
+    {&Textures::duck_red_dead, "textures/duck_red_dead.png", "textures/original/duck_red_dead.png", 1},
+    {&Textures::duck_red_diagonal, "textures/duck_red_diagonal.png", "textures/original/duck_red_diagonal.png", 3},
+    {&Textures::duck_red_falling, "textures/duck_red_falling.png", "textures/original/duck_red_falling.png", 4},
+    {&Textures::duck_red_horizontal, "textures/duck_red_horizontal.png", "textures/original/duck_red_horizontal.png", 3},
+    {&Textures::duck_red_vertical, "textures/duck_red_vertical.png", "textures/original/duck_red_vertical.png", 3},
+    {&Textures::duck_score, "textures/duck_score.png", "textures/duck_score.png", 8},
+    {&Textures::foreground, "textures/foreground.png", "textures/original/foreground.png", 1},
+    {&Textures::main_menu_background, "textures/main_menu_background.png", "textures/original/main_menu_background.png", 1}
+}};
+
 /**
-* Loads an image into a texture on the rendering device
+* Loads an image into a surface in the format used by the texture atlas
 * @param file The image file to load
-* @param ren The renderer to load the texture onto
-* @return the loaded texture, or nullptr if something went wrong.
+* @param os The output stream to write errors to
+* @return the loaded surface, or nullptr if something went wrong.
 */
-SDL_Texture* loadTexture(const std::string &file, SDL_Renderer *ren){
-    //Initialize to nullptr to avoid dangling pointer issues
-    SDL_Texture *texture = nullptr;
+inline SDL_Surface* loadSurface(const std::string &file, std::ostream &os = std::cout){
     //Load the image
     SDL_Surface *loadedImage = IMG_Load(file.c_str());
-    //If the loading went ok, convert to texture and return the texture
-    if (loadedImage != nullptr){
-        texture = SDL_CreateTextureFromSurface(ren, loadedImage);
-        SDL_FreeSurface(loadedImage);
-        //Make sure converting went ok too
-        if (texture == nullptr){
-            logSDLError(std::cout, "CreateTextureFromSurface");
-        }
+    if (loadedImage == nullptr){
+        logSDLError(os, "IMG_Load " + file);
+        return nullptr;
     }
-    else {
-        logSDLError(std::cout, "LoadBMP");
+    //Convert to the atlas' pixel format so blits are plain copies
+    SDL_Surface *surface = SDL_ConvertSurfaceFormat(loadedImage, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_FreeSurface(loadedImage);
+    if (surface == nullptr){
+        logSDLError(os, "ConvertSurfaceFormat " + file);
     }
-    return texture;
+    return surface;
 }
 
 /// Determines the rects for each frame on a animation strip, this assumes equal width and no gaps.
-/// \param texture The texture to split.
+/// \param region The region of the atlas holding the strip.
 /// \param size the number of frames.
-/// \return The frames.
-std::vector<SDL_Rect> spriteStripRects(SDL_Texture* texture, size_t size) {
+/// \return The frames, in atlas coordinates.
+inline std::vector<SDL_Rect> spriteStripRects(const TextureRegion &region, size_t size) {
     std::vector<SDL_Rect> frames;
     frames.reserve(size);
-    int w, h;
-    SDL_QueryTexture(texture, nullptr, nullptr, &w, &h);
-    w /= size;
+    int w = region.rect.w / static_cast<int>(size);
+    int h = region.rect.h;
     for (int i = 0; i < size; ++i) {
         // x, y, w, h
-        frames.push_back({w * i, 0, w, h});
+        frames.push_back({region.rect.x + w * i, region.rect.y, w, h});
     }
 
     return frames;
 }
 
-Textures loadTexturesOriginal(SDL_Renderer* renderer) {
-    return {
-        .ui_bullet = loadTexture("textures/original/ui_bullet.png", renderer),
-        .ui_duck_lit = loadTexture("textures/original/ui_duck_lit.png", renderer),
-        .ui_duck_white = loadTexture("textures/original/ui_duck_white.png", renderer),
-        .ui_ducks_needed_bar = loadTexture("textures/original/ui_ducks_needed_bar.png", renderer),
-        .ui_hit = loadTexture("textures/original/ui_hit.png", renderer),
-        .ui_message_fly_away = loadTexture("textures/ui_message_fly_away.png", renderer),
-        .ui_message_game_over = loadTexture("textures/ui_message_game_over.png", renderer),
-        .ui_message_round = loadTexture("textures/ui_message_round.png", renderer),
-        .ui_numbers_green = loadTexture("textures/ui_numbers_green.png", renderer),
-        .ui_numbers_white = loadTexture("textures/ui_numbers_white.png", renderer),
-        .ui_score = loadTexture("textures/original/ui_score.png", renderer),
-        .ui_shot = loadTexture("textures/original/ui_shot.png", renderer),
-        .ui_round = loadTexture("textures/ui_round.png", renderer),
-        .background = loadTexture("textures/original/background.png", renderer),
-        .background_fail = loadTexture("textures/original/background_fail.png", renderer),
-        .dog_failure = loadTexture("textures/original/dog_failure.png", renderer),
-        .dog_jumping = loadTexture("textures/original/dog_jumping.png", renderer),
-        .dog_sniffing = loadTexture("textures/original/dog_sniffing.png", renderer),
-        .dog_success = loadTexture("textures/original/dog_success.png", renderer),
-        .duck_blue_dead = loadTexture("textures/original/duck_blue_dead.png", renderer),
-        .duck_blue_diagonal = loadTexture("textures/original/duck_blue_diagonal.png", renderer),
-        .duck_blue_falling = loadTexture("textures/original/duck_blue_falling.png", renderer),
-        .duck_blue_horizontal = loadTexture("textures/original/duck_blue_horizontal.png", renderer),
-        .duck_blue_vertical = loadTexture("textures/original/duck_blue_vertical.png", renderer),
-        .duck_brown_dead = loadTexture("textures/original/duck_brown_dead.png", renderer),
-        .duck_brown_diagonal = loadTexture("textures/original/duck_brown_diagonal.png", renderer),
-        .duck_brown_falling = loadTexture("textures/original/duck_brown_falling.png", renderer),
-        .duck_brown_horizontal = loadTexture("textures/original/duck_brown_horizontal.png", renderer),
-        .duck_brown_vertical = loadTexture("textures/original/duck_brown_vertical.png", renderer),
-        .duck_red_dead = loadTexture("textures/original/duck_red_dead.png", renderer),
-        .duck_red_diagonal = loadTexture("textures/original/duck_red_diagonal.png", renderer),
-        .duck_red_falling = loadTexture("textures/original/duck_red_falling.png", renderer),
-        .duck_red_horizontal = loadTexture("textures/original/duck_red_horizontal.png", renderer),
-        .duck_red_vertical = loadTexture("textures/original/duck_red_vertical.png", renderer),
-        .duck_score = loadTexture("textures/duck_score.png", renderer),
-        .foreground = loadTexture("textures/original/foreground.png", renderer),
-        .main_menu_background = loadTexture("textures/original/main_menu_background.png", renderer)
-    };
+/// An animation strip on the atlas, with equal width frames and no gaps.
+/// The frames are worked out from the region when asked for, so they follow the region when a texture set is swapped.
+struct SpriteStrip {
+    const TextureRegion* region;
+    int frames;
+
+    SDL_Texture* texture() const {
+        return region->texture;
+    }
+
+    /// The rect of a frame, in atlas coordinates.
+    SDL_Rect frame(int index) const {
+        int w = region->rect.w / frames;
+        return {region->rect.x + w * index, region->rect.y, w, region->rect.h};
+    }
+
+    int frameWidth() const {
+        return region->rect.w / frames;
+    }
+
+    int frameHeight() const {
+        return region->rect.h;
+    }
+};
+
+/// Tests a point against the opaque pixels of a frame of a strip.
+/// \param textures The textures holding the strip and the masks of their images.
+/// \param strip The strip.
+/// \param frame The frame drawn.
+/// \param flipped Whether the frame is drawn mirrored horizontally.
+/// \param x The x coordinate of the point relative to where the frame is drawn.
+/// \param y The y coordinate of the point relative to where the frame is drawn.
+/// \return true if the point is on an opaque pixel, or anywhere on the frame if its image has no mask.
+inline bool stripHit(const Textures* textures, const SpriteStrip &strip, int frame, bool flipped, int x, int y) {
+    int w = strip.frameWidth();
+    if (x < 0 || y < 0 || x >= w || y >= strip.frameHeight())
+        return false;
+    if (strip.region->mask < 0)
+        return true;
+    const AlphaMask &mask = textures->masks[strip.region->mask];
+    return mask.isEmpty() || mask.test(frame * w + (flipped ? w - 1 - x : x), y);
+}
+
+/// Wraps the pixels of every texture of a set in a texture pack in surfaces, without copying them.
+/// \param pack The open texture pack, which must stay open while the surfaces are used.
+/// \param remake true for the remake's textures, false for the original game's textures.
+/// \param surfaces The surfaces to fill in, one per entry of textureFiles.
+/// \return false if a texture is missing from the pack or out of date, in which case no surfaces are made.
+inline bool loadPackedSurfaces(const TexturePack &pack, bool remake, std::vector<SDL_Surface*>* surfaces) {
+    std::vector<const PackEntry*> entries;
+    for (auto &file : textureFiles) {
+        const PackEntry* entry = pack.find(remake ? file.remake : file.original);
+        if (entry == nullptr || !TexturePack::isCurrent(*entry, file.frames))
+            return false;
+        entries.push_back(entry);
+    }
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const PackEntry &entry = *entries[i];
+        (*surfaces)[i] = SDL_CreateRGBSurfaceWithFormatFrom(const_cast<void*>(pack.pixels(entry)), entry.width,
+                                                            entry.height, 32, entry.pitch, SDL_PIXELFORMAT_ARGB8888);
+        if ((*surfaces)[i] == nullptr)
+            logSDLError(std::cout, std::string("CreateRGBSurfaceWithFormatFrom ") + entry.source);
+    }
+    return true;
+}
+
+/// The decoded images of a texture set, waiting to be packed onto atlas pages.
+struct DecodedTextures {
+    bool remake = true;
+    /// The texture pack the surfaces point into, when they came from one.
+    TexturePack pack;
+    /// One surface per entry of textureFiles, nullptr where an image failed to load.
+    std::vector<SDL_Surface*> surfaces;
+
+    DecodedTextures() = default;
+    DecodedTextures(const DecodedTextures&) = delete;
+    DecodedTextures& operator=(const DecodedTextures&) = delete;
+
+    ~DecodedTextures() {
+        for (SDL_Surface* surface : surfaces)
+            SDL_FreeSurface(surface);
+    }
+};
+
+/// Decodes every texture of a set, from the texture pack when it is up to date and otherwise from the PNGs on a pool
+/// of threads. This does not touch the renderer, so it can run on any thread.
+/// \param remake true for the remake's textures, false for the original game's textures.
+/// \param decoded Where to put the images.
+inline void decodeTextures(bool remake, DecodedTextures* decoded) {
+    decoded->remake = remake;
+    decoded->surfaces.assign(textureFiles.size(), nullptr);
+    std::vector<std::ostringstream> errors(textureFiles.size());
+
+    bool packed = decoded->pack.open(texturePackFile);
+    if (packed && !loadPackedSurfaces(decoded->pack, remake, &decoded->surfaces)) {
+        std::cout << "Texture pack " << texturePackFile << " is out of date, loading PNGs" << std::endl;
+        packed = false;
+    }
+    if (!packed) {
+        // Load the PNG decoder before the workers need it
+        IMG_Init(IMG_INIT_PNG);
+        parallelFor(textureFiles.size(), [&](size_t i) {
+            TRACE_ZONE("loadSurface");
+            const TextureFile &file = textureFiles[i];
+            decoded->surfaces[i] = loadSurface(remake ? file.remake : file.original, errors[i]);
+        });
+    }
+    for (auto &error : errors)
+        std::cout << error.str();
+}
+
+/// Packs decoded images onto atlas pages. Must be called on the thread that owns the renderer.
+/// \param renderer The renderer to create the atlas pages on, or nullptr to only work out where each texture goes.
+/// \param decoded The images, which can be freed afterwards.
+/// \return The regions of each texture, a region's texture is nullptr if it failed to load.
+inline Textures buildTextures(SDL_Renderer* renderer, const DecodedTextures &decoded) {
+    Textures textures{};
+    AtlasBuilder atlas(renderer);
+    for (size_t i = 0; i < textureFiles.size(); ++i) {
+        TextureRegion* region = &(textures.*textureFiles[i].region);
+        atlas.add(decoded.surfaces[i], region);
+        region->mask = static_cast<int>(textures.masks.size());
+        textures.masks.emplace_back(decoded.surfaces[i]);
+    }
+
+    textures.pages = atlas.build(renderer);
+    textures.font_green = BitmapFont(textures.ui_numbers_green);
+    textures.font_white = BitmapFont(textures.ui_numbers_white);
+    return textures;
+}
+
+/// Loads every texture of a set and packs them onto atlas pages.
+/// \param renderer The renderer to create the atlas pages on, or nullptr to only work out where each texture goes.
+/// \param remake true for the remake's textures, false for the original game's textures.
+/// \return The regions of each texture, a region's texture is nullptr if it failed to load.
+inline Textures loadTextures(SDL_Renderer* renderer, bool remake) {
+    TRACE_ZONE(remake ? "loadTexturesRemake" : "loadTexturesOriginal");
+    DecodedTextures decoded;
+    decodeTextures(remake, &decoded);
+    return buildTextures(renderer, decoded);
+}
+
+inline Textures loadTexturesOriginal(SDL_Renderer* renderer) {
+    return loadTextures(renderer, false);
 }
 
-Textures loadTexturesRemake(SDL_Renderer* renderer) {
-    return {
-        .ui_bullet = loadTexture("textures/ui_bullet.png", renderer),
-        .ui_duck_lit = loadTexture("textures/ui_duck_lit.png", renderer),
-        .ui_duck_white = loadTexture("textures/ui_duck_white.png", renderer),
-        .ui_ducks_needed_bar = loadTexture("textures/ui_ducks_needed_bar.png", renderer),
-        .ui_hit = loadTexture("textures/ui_hit.png", renderer),
-        .ui_message_fly_away = loadTexture("textures/ui_message_fly_away.png", renderer),
-        .ui_message_game_over = loadTexture("textures/ui_message_game_over.png", renderer),
-        .ui_message_round = loadTexture("textures/ui_message_round.png", renderer),
-        .ui_numbers_green = loadTexture("textures/ui_numbers_green.png", renderer),
-        .ui_numbers_white = loadTexture("textures/ui_numbers_white.png", renderer),
-        .ui_score = loadTexture("textures/ui_score.png", renderer),
-        .ui_shot = loadTexture("textures/ui_shot.png", renderer),
-        .ui_round = loadTexture("textures/ui_round.png", renderer),
-        .background = loadTexture("textures/background.png", renderer),
-        .background_fail = loadTexture("textures/background_fail.png", renderer),
-        .dog_failure = loadTexture("textures/dog_failure.png", renderer),
-        .dog_jumping = loadTexture("textures/dog_jumping.png", renderer),
-        .dog_sniffing = loadTexture("textures/dog_sniffing.png", renderer),
-        .dog_success = loadTexture("textures/dog_success.png", renderer),
-        .duck_blue_dead = loadTexture("textures/duck_blue_dead.png", renderer),
-        .duck_blue_diagonal = loadTexture("textures/duck_blue_diagonal.png", renderer),
-        .duck_blue_falling = loadTexture("textures/duck_blue_falling.png", renderer),
-        .duck_blue_horizontal = loadTexture("textures/duck_blue_horizontal.png", renderer),
-        .duck_blue_vertical = loadTexture("textures/duck_blue_vertical.png", renderer),
-        .duck_brown_dead = loadTexture("textures/duck_brown_dead.png", renderer),
-        .duck_brown_diagonal = loadTexture("textures/duck_brown_diagonal.png", renderer),
-        .duck_brown_falling = loadTexture("textures/duck_brown_falling.png", renderer),
-        .duck_brown_horizontal = loadTexture("textures/duck_brown_horizontal.png", renderer),
-        .duck_brown_vertical = loadTexture("textures/duck_brown_vertical.png", renderer),
-        .duck_red_dead = loadTexture("textures/duck_red_dead.png", renderer),
-        .duck_red_diagonal = loadTexture("textures/duck_red_diagonal.png", renderer),
-        .duck_red_falling = loadTexture("textures/duck_red_falling.png", renderer),
-        .duck_red_horizontal = loadTexture("textures/duck_red_horizontal.png", renderer),
-        .duck_red_vertical = loadTexture("textures/duck_red_vertical.png", renderer),
-        .duck_score = loadTexture("textures/duck_score.png", renderer),
-        .foreground = loadTexture("textures/foreground.png", renderer),
-        .main_menu_background = loadTexture("textures/main_menu_background.png", renderer)
-    };
+inline Textures loadTexturesRemake(SDL_Renderer* renderer) {
+    return loadTextures(renderer, true);
 }
 
-bool validateTextures(Textures* textures) {
-    return (
-        textures->ui_bullet != nullptr &&
-        textures->ui_duck_lit != nullptr &&
-        textures->ui_duck_white != nullptr &&
-        textures->ui_ducks_needed_bar != nullptr &&
-        textures->ui_hit != nullptr &&
-        textures->ui_message_fly_away != nullptr &&
-        textures->ui_message_game_over != nullptr &&
-        textures->ui_message_round != nullptr &&
-        textures->ui_numbers_green != nullptr &&
-        textures->ui_numbers_white != nullptr &&
-        textures->ui_score != nullptr &&
-        textures->ui_shot != nullptr &&
-        textures->ui_round != nullptr &&
-        textures->background != nullptr &&
-        textures->background_fail != nullptr &&
-        textures->dog_failure != nullptr &&
-        textures->dog_jumping != nullptr &&
-        textures->dog_sniffing != nullptr &&
-        textures->dog_success != nullptr &&
-        textures->duck_blue_dead != nullptr &&
-        textures->duck_blue_diagonal != nullptr &&
-        textures->duck_blue_falling != nullptr &&
-        textures->duck_blue_horizontal != nullptr &&
-        textures->duck_blue_vertical != nullptr &&
-        textures->duck_brown_dead != nullptr &&
-        textures->duck_brown_diagonal != nullptr &&
-        textures->duck_brown_falling != nullptr &&
-        textures->duck_brown_horizontal != nullptr &&
-        textures->duck_brown_vertical != nullptr &&
-        textures->duck_red_dead != nullptr &&
-        textures->duck_red_diagonal != nullptr &&
-        textures->duck_red_falling != nullptr &&
-        textures->duck_red_horizontal != nullptr &&
-        textures->duck_red_vertical != nullptr &&
-        textures->duck_score != nullptr &&
-        textures->foreground != nullptr &&
-        textures->main_menu_background != nullptr
-    );
+/// Checks that every texture was loaded.
+/// \param textures The textures to check.
+/// \param requirePages false if the textures were loaded without a renderer, so only their sizes are known.
+inline bool validateTextures(Textures* textures, bool requirePages = true) {
+    return std::all_of(textureFiles.begin(), textureFiles.end(), [textures, requirePages](const TextureFile &file) {
+        const TextureRegion &region = textures->*file.region;
+        return region.rect.w > 0 && (region.texture != nullptr || !requirePages);
+    });
 };
 
 #endif //DUCKHUNT_TEXTURES_HPP
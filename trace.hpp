@@ -0,0 +1,198 @@
+#ifndef DUCKHUNT_TRACE_HPP
+#define DUCKHUNT_TRACE_HPP
+
+// Trace zones record when a scope was entered and left, to be looked at on a timeline in chrome://tracing or
+// Perfetto. They are only compiled in when DUCKHUNT_TRACE is defined, otherwise the macros expand to nothing.
+//   TRACE_ZONE(name)     Records the enclosing scope under name, which must be a string that outlives the program.
+//   TRACE_SPAN(name, start, end) Records a zone measured some other way, start and end are performance counter values.
+//   TRACE_DUMP(filename) Writes every recorded zone as Chrome trace-event JSON.
+
+/// Where traces are written on exit and on the dump hotkey.
+const char* const traceFile = "./trace.json";
+
+#ifdef DUCKHUNT_TRACE
+
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "SDL2/SDL.h"
+
+struct TraceEvent {
+    const char* name;
+    Uint64 start;
+    Uint64 end;
+};
+
+/// The last ::capacity zones recorded on one thread, oldest overwritten first.
+/// Only the owning thread records, without locking, so tracing does not slow the frames it measures. Another thread
+/// can read the buffer meanwhile: the slots are written as a seqlock, with relaxed atomic fields and a count of the
+/// events begun before them, so a reader skips the events that are overwritten as it reads them.
+class TraceBuffer {
+public:
+    static constexpr size_t capacity = 1 << 16;
+
+private:
+    struct Slot {
+        std::atomic<const char*> name{nullptr};
+        std::atomic<Uint64> start{0};
+        std::atomic<Uint64> end{0};
+    };
+
+    std::array<Slot, capacity> slots;
+    /// The events begun, counted before a slot is written.
+    std::atomic<size_t> begun{0};
+    /// The events recorded, counted once their slot is written.
+    std::atomic<size_t> count{0};
+
+public:
+    /// The id the events are written under, kept by the threads the buffer is handed on to.
+    const int thread;
+
+    explicit TraceBuffer(int thread) : thread(thread) {}
+
+    void record(const TraceEvent &event) {
+        size_t recorded = count.load(std::memory_order_relaxed);
+        Slot &slot = slots[recorded % capacity];
+        begun.store(recorded + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.name.store(event.name, std::memory_order_relaxed);
+        slot.start.store(event.start, std::memory_order_relaxed);
+        slot.end.store(event.end, std::memory_order_relaxed);
+        count.store(recorded + 1, std::memory_order_release);
+    }
+
+    /// Calls visit with each recorded event, oldest first.
+    template<typename Visitor>
+    void forEach(Visitor visit) const {
+        size_t end = count.load(std::memory_order_acquire);
+        size_t first = end > capacity ? end - capacity : 0;
+        for (size_t i = first; i < end; ++i) {
+            const Slot &slot = slots[i % capacity];
+            TraceEvent event{slot.name.load(std::memory_order_relaxed), slot.start.load(std::memory_order_relaxed),
+                             slot.end.load(std::memory_order_relaxed)};
+            // The owning thread may have come round to this slot again while it was read
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (begun.load(std::memory_order_relaxed) - i > capacity)
+                continue;
+            visit(event);
+        }
+    }
+};
+
+/// Owns every thread's TraceBuffer, so that zones recorded by threads that have finished can still be written.
+/// A finished thread's buffer is handed to the next thread that records, so threads started over and over, e.g. the
+/// workers of parallelFor, need no more buffers than run at once.
+class Tracer {
+private:
+    /// Holds a thread's buffer, giving it back to the tracer when the thread finishes.
+    struct Lease {
+        TraceBuffer* buffer;
+
+        Lease() : buffer(get().takeBuffer()) {}
+
+        ~Lease() {
+            get().giveBack(buffer);
+        }
+    };
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<TraceBuffer>> buffers;
+    /// The buffers of the threads that have finished, waiting for a new thread.
+    std::vector<TraceBuffer*> freeBuffers;
+
+public:
+    static Tracer &get() {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    /// The buffer of the calling thread, taken on first use.
+    static TraceBuffer &buffer() {
+        thread_local Lease lease;
+        return *lease.buffer;
+    }
+
+    /// Writes every recorded zone as Chrome trace-event JSON.
+    /// \param filename The file to write to.
+    void write(const std::string &filename) {
+        std::ofstream file(filename, std::ios::trunc);
+        if (!file.good()) {
+            std::cout << "Could not write trace " << filename << std::endl;
+            return;
+        }
+        double usPerTick = 1000000.0 / SDL_GetPerformanceFrequency();
+        bool first = true;
+        // Timestamps are microseconds since the performance counter started, too many digits for the default precision
+        file << std::fixed << std::setprecision(3);
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto &buffer : buffers)
+            buffer->forEach([&](const TraceEvent &event) {
+                file << (first ? "\n" : ",\n") << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                     << buffer->thread << ",\"ts\":" << event.start * usPerTick
+                     << ",\"dur\":" << (event.end - event.start) * usPerTick << "}";
+                first = false;
+            });
+        file << "\n]}\n";
+        std::cout << "Wrote trace " << filename << std::endl;
+    }
+
+private:
+    TraceBuffer* takeBuffer() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!freeBuffers.empty()) {
+            TraceBuffer* buffer = freeBuffers.back();
+            freeBuffers.pop_back();
+            return buffer;
+        }
+        buffers.push_back(std::make_unique<TraceBuffer>(static_cast<int>(buffers.size()) + 1));
+        return buffers.back().get();
+    }
+
+    void giveBack(TraceBuffer* buffer) {
+        std::lock_guard<std::mutex> lock(mutex);
+        freeBuffers.push_back(buffer);
+    }
+};
+
+/// Records the time from its construction to its destruction as a zone.
+class TraceZone {
+private:
+    const char* name;
+    Uint64 start;
+
+public:
+    explicit TraceZone(const char* name) {
+        this->name = name;
+        start = SDL_GetPerformanceCounter();
+    }
+
+    TraceZone(const TraceZone&) = delete;
+    TraceZone& operator=(const TraceZone&) = delete;
+
+    ~TraceZone() {
+        Tracer::buffer().record({name, start, SDL_GetPerformanceCounter()});
+    }
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_ZONE(name) TraceZone TRACE_CONCAT(traceZone, __LINE__)(name)
+#define TRACE_SPAN(name, start, end) Tracer::buffer().record({name, start, end})
+#define TRACE_DUMP(filename) Tracer::get().write(filename)
+
+#else
+
+#define TRACE_ZONE(name)
+#define TRACE_SPAN(name, start, end)
+#define TRACE_DUMP(filename)
+
+#endif //DUCKHUNT_TRACE
+
+#endif //DUCKHUNT_TRACE_HPP